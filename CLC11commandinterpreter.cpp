@@ -7,19 +7,24 @@
 #include <sstream>
 #include <memory>
 #include <algorithm>
+#include <fstream>
+#include <fcntl.h>
+#include <charconv>
+#include <string_view>
 
 class CommandParser 
 {
 private:
 
     std::unordered_map<std::string, std::unique_ptr<Command>> commands;        //mappa dei nomi dei comandi
+    std::unique_ptr<TraceRecorder> recorder;                                   //registrazione dei comandi (se attiva)
     
-    std::vector<std::string> tokenize(const std::string& input)
+    std::vector<Token> tokenize(const std::string& input)    //i nomi tra virgolette vengono risolti qui, una volta per comando
 {
     bool virgolettato = false;
     int tLength = 0;
     int sIndex = 0;
-    std::vector<std::string> tokens;
+    std::vector<Token> tokens;
 
     for (int i = 0; i < input.length(); i++)
     {
@@ -27,7 +32,7 @@ private:
         {
             if (tLength > 0) 
             {
-                tokens.push_back(input.substr(sIndex, tLength));
+                tokens.push_back({input.substr(sIndex, tLength)});
                 tLength = 0;
             }
             sIndex = i + 1;
@@ -41,7 +46,9 @@ private:
             }
             else 
             {
-                tokens.push_back(input.substr(sIndex, i - sIndex));
+                std::string nome = input.substr(sIndex, i - sIndex);
+                DeviceHandle device = dm.findHandle(nome);
+                tokens.push_back({std::move(nome), device, true});
                 tLength = 0;
                 sIndex = i + 1;
             }
@@ -50,7 +57,7 @@ private:
     }
     if (tLength > 0) 
     {
-        tokens.push_back(input.substr(sIndex, tLength));
+        tokens.push_back({input.substr(sIndex, tLength), INVALID_DEVICE, virgolettato});   //virgolette non chiuse: prefisso di un nome
     }
     return std::move(tokens);
 }
@@ -63,43 +70,288 @@ public:
         commands["reset"] = std::unique_ptr<Command>(new ResetCommand());
         commands["rm"] = std::unique_ptr<Command>(new RmCommand());
         commands["show"] = std::unique_ptr<Command>(new ShowCommand());
+        commands["ls"] = std::unique_ptr<Command>(new LsCommand());
+        commands["mem"] = std::unique_ptr<Command>(new MemCommand());
+    }
+    
+    void showCompletions(const std::string& input)     //riga terminata da TAB: completa il nome tra virgolette aperto
+    {
+        std::string line = input.substr(0, input.find_last_not_of('\t') + 1);
+        std::size_t aperte = std::count(line.begin(), line.end(), '"');
+        if (aperte % 2 == 0)
+        {
+            return;                                     //nessun nome da completare
+        }
+        
+        std::size_t inizio = line.rfind('"') + 1;
+        std::string prefisso = line.substr(inizio);
+        std::string completo = dm.completeDevice(prefisso);
+        std::vector<std::string> candidati = dm.listDevices(prefisso, 20);
+        
+        out << line.substr(0, inizio) << completo;
+        if (candidati.size() == 1) out << '"';
+        out << '\n';
+        if (candidati.size() > 1)
+        {
+            for (const auto& nome : candidati) out << "  " << nome << '\n';
+        }
+        out.flush();
     }
         
+    void startRecording(const std::string& path)       //ogni riga ricevuta viene salvata con il suo timestamp
+    {
+        recorder.reset(new TraceRecorder(path));
+    }
+    
     void processInput(const std::string& input) 
     {
-        std::vector<std::string> tokens = tokenize(input);
+        if (recorder) recorder->record(input);
+        
+        std::vector<Token> tokens = tokenize(input);
         
         if (tokens.empty()) 
         {
-            cout<<"Inserire un comando!\n";
+            out<<"Inserire un comando!\n";
+            out.flush();
             return;
         }
         
-        std::string commandName = tokens[0];
+        const std::string& commandName = tokens[0].text;
         
         // Check if command exists
         auto it = commands.find(commandName);
         if (it == commands.end()) 
         {
-            std::cout << "Il comando inserito non e' valido: "<<commandName<<std::endl;
+            out << "Il comando inserito non e' valido: " << commandName << '\n';
+            out.flush();
             return;
         }
         
+        //nome sconosciuto: suggerisci i dispositivi con nome simile (ls accetta prefissi)
+        if (commandName != "ls")
+        {
+            for (const auto& token : tokens)
+            {
+                if (!token.quoted || token.device != INVALID_DEVICE) continue;
+                std::vector<std::string> simili = dm.suggestDevices(token.text);
+                out << "Dispositivo sconosciuto: \"" << token.text << "\"";
+                for (std::size_t i = 0; i < simili.size(); i++)
+                {
+                    out << (i == 0 ? ". Forse intendevi: \"" : ", \"") << simili[i] << "\"";
+                }
+                out << '\n';
+            }
+        }
+        
         //rimozione del comando dal vettore dei token
-        std::vector<std::string> args(tokens.begin() + 1, tokens.end());
+        std::vector<Token> args(tokens.begin() + 1, tokens.end());
         
         //passaggio al secondo livello (controllo parametri)
         it->second->execute(args);
+        
+        //l'output del comando viene scritto tutto insieme
+        out.flush();
+    }
+    
+};
+
+//scarta l'output dei comandi (cout e buffer) finche' esiste: il distruttore
+//ripristina tutto anche quando un comando lancia un'eccezione
+class OutputSilencer
+{
+private:
+    std::ofstream nullStream;
+    std::streambuf* coutBuffer;
+    OutputBuffer& out;
+    int nullFd;
+    
+public:
+    explicit OutputSilencer(OutputBuffer& out)
+        : nullStream("/dev/null"), coutBuffer(std::cout.rdbuf(nullStream.rdbuf())), out(out), nullFd(open("/dev/null", O_WRONLY))
+    {
+        out.redirect(nullFd);
     }
     
+    OutputSilencer(const OutputSilencer&) = delete;
+    OutputSilencer& operator=(const OutputSilencer&) = delete;
+    
+    ~OutputSilencer()
+    {
+        out.clear();                    //l'output del comando interrotto non deve arrivare al terminale
+        out.redirect(STDOUT_FILENO);
+        close(nullFd);
+        std::cout.rdbuf(coutBuffer);
+    }
 };
 
-int main() 
+//riproduce una traccia registrata con --record e confronta il throughput con la baseline
+int replay(CommandParser& parser, TimeManager& tm, OutputBuffer& out, const std::string& tracePath, const std::string& baselinePath)
+{
+    TraceStats stats;
+    try
+    {
+        //l'output dei comandi non interessa: viene scartato per misurare solo il simulatore
+        OutputSilencer silencer(out);
+        stats = replayTrace(tracePath,
+            [&parser](const std::string& line) { parser.processInput(line); },
+            [&tm]() { return tm.getCurrentMinutes(); });
+    }
+    catch (const std::exception& e)
+    {
+        std::cout<<"Riproduzione interrotta: "<<e.what()<<"\n";
+        return 1;
+    }
+    
+    std::cout<<"Comandi: "<<stats.commands<<" ("<<stats.commandsPerSecond()<<" comandi/s)\n";
+    std::cout<<"Minuti simulati: "<<stats.simulatedMinutes<<" ("<<stats.minutesPerSecond()<<" minuti/s)\n";
+    std::cout<<"Latenza (us): p50 "<<stats.p50Us<<", p90 "<<stats.p90Us<<", p99 "<<stats.p99Us<<", max "<<stats.maxUs<<"\n";
+    std::cout<<"Picco RSS: "<<stats.peakRssKb<<" kB\n";
+    
+    if (baselinePath.empty()) return 0;
+    
+    double baseline = readTraceBaseline(baselinePath);
+    if (baseline <= 0.0)            //prima esecuzione: la misura diventa la baseline
+    {
+        writeTraceBaseline(baselinePath, stats);
+        return 0;
+    }
+    if (stats.commandsPerSecond() < 0.9 * baseline)          //tolleranza del 10% sul rumore di misura
+    {
+        std::cout<<"REGRESSIONE: "<<stats.commandsPerSecond()<<" comandi/s contro una baseline di "<<baseline<<"\n";
+        return 1;
+    }
+    return 0;
+}
+
+int script(DeviceManager& dm, TimeManager& tm, OutputBuffer& out, const std::string& path, int argc, char* argv[])
+{
+    std::vector<int> parametri;                 //$0, $1, ...: minuti per gli orari, Wh per "over", numeri per "top"
+    for (int i = 0; i < argc; i++)
+    {
+        std::string_view testo(argv[i]);
+        int valore = 0;
+        auto [fine, errore] = std::from_chars(testo.data(), testo.data() + testo.size(), valore);
+        if (errore != std::errc() || fine != testo.data() + testo.size())
+        {
+            std::cout<<"Parametro $"<<i<<" non valido: "<<testo<<"\n";
+            return 1;
+        }
+        parametri.push_back(valore);
+    }
+    try
+    {
+        CompiledScript compilato = ScriptCompiler(dm).compileFile(path);
+        runScript(compilato, dm, tm, out, parametri);
+    }
+    catch (const std::exception& e)
+    {
+        out.flush();                            //quanto eseguito prima dell'errore resta visibile
+        std::cout<<"Script interrotto: "<<e.what()<<"\n";
+        return 1;
+    }
+    out.flush();
+    return 0;
+}
+
+int main(int argc, char* argv[]) 
 {
     CommandParser parser;
     DeviceManager dm;
     TimeManager tm;
+    OutputBuffer out;
     
+    //HomeManager [--threads <n>] [--admission] [--status <shm>] [--shedding lowest|minimal] --record <traccia>  |  --replay <traccia> [baseline]  |  --serve <socket>  |  --script <file> [parametri]
+    //le opzioni della casa vanno prima della modalita', in qualsiasi ordine
+    while (argc >= 2 && std::string(argv[1]) != "--serve" && std::string(argv[1]) != "--replay"
+           && std::string(argv[1]) != "--script" && std::string(argv[1]) != "--record")
+    {
+        std::string opzione(argv[1]);
+        if (opzione == "--admission")
+        {
+            dm.setAdmissionControl(true);                   //le accensioni oltre il limite vengono rinviate invece di distaccare altri carichi
+            argc -= 1;
+            argv += 1;
+            continue;
+        }
+        if (opzione != "--threads" && opzione != "--status" && opzione != "--shedding")
+        {
+            std::cout<<"Opzione non valida: "<<opzione<<"\n";
+            return 1;
+        }
+        if (argc < 3)
+        {
+            std::cout<<"Manca il valore di "<<opzione<<"\n";
+            return 1;
+        }
+        if (opzione == "--threads")
+        {
+            std::string_view testo(argv[2]);
+            int threads = 0;
+            auto [fine, errore] = std::from_chars(testo.data(), testo.data() + testo.size(), threads);
+            if (errore != std::errc() || fine != testo.data() + testo.size() || threads < 1 || threads > 256)
+            {
+                std::cout<<"Numero di thread non valido: "<<testo<<" (da 1 a 256)\n";
+                return 1;
+            }
+            dm.setTickThreads(static_cast<unsigned>(threads));  //valutazione dei tick divisa in shard di timer e cicli
+        }
+        else if (opzione == "--status")
+        {
+            dm.attachStatusPage(argv[2]);                   //pagina di stato per i monitor esterni (statusreader), cresce con i dispositivi
+        }
+        else
+        {
+            try
+            {
+                dm.setSheddingStrategy(makeSheddingStrategy(argv[2]));  //strategia di distacco di questa casa
+            }
+            catch (const std::invalid_argument&)
+            {
+                std::cout<<"Strategia di distacco non valida: "<<argv[2]<<" (lowest o minimal)\n";
+                return 1;
+            }
+        }
+        argc -= 2;
+        argv += 2;
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--serve")
+    {
+        out.redirect(-1);                       //le risposte restano nel buffer e vanno al client
+        CommandServer server(argv[2]);
+        server.run([&parser, &out](const std::string& line, std::string& risposta)
+        {
+            try
+            {
+                parser.processInput(line);
+            }
+            catch (...)                         //l'output parziale resta a questo client, l'errore lo scrive il server
+            {
+                risposta.append(out.view());
+                out.clear();
+                throw;
+            }
+            risposta.append(out.view());
+            out.clear();
+        });
+        return 0;
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--replay")
+    {
+        return replay(parser, tm, out, argv[2], argc >= 4 ? argv[3] : "");
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--script")
+    {
+        return script(dm, tm, out, argv[2], argc - 3, argv + 3);
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--record")
+    {
+        parser.startRecording(argv[2]);
+    }
+    else if (argc >= 2)
+    {
+        std::cout<<"Manca il valore di "<<argv[1]<<"\n";  //una modalita' senza argomento
+        return 1;
+    }
     
     std::string input;
     
@@ -119,6 +371,10 @@ int main()
         {
             parser.showHelp();
         } 
+        else if (!input.empty() && input.back() == '\t')
+        {
+            parser.showCompletions(input);
+        }
         else 
         {
             parser.processInput(input);
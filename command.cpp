@@ -1,14 +1,22 @@
 
 
+struct Token          //token del comando: i nomi tra virgolette sono gia' risolti nell'handle del dispositivo
+{
+    std::string text;
+    DeviceHandle device = INVALID_DEVICE;
+    bool quoted = false;
+};
+
 class Command         //classe di base per ciascun comando
 {
-  void printInvalid() const
+protected:
+  void printInvalid() const       //nello stesso buffer del resto dell'output: ordine corretto anche verso i client
     {
-        cout<<"Comando inserito non valido, Riprovare.\n";
+        out<<"Comando inserito non valido, Riprovare.\n";
     }
-    virtual int checkArgs(const std::vector<std::string>& args) = 0;
+    virtual int checkArgs(const std::vector<Token>& args) = 0;
 
 public:
     virtual ~Command() = default;
-    virtual void execute(const std::vector<std::string>& args) = 0;
+    virtual void execute(const std::vector<Token>& args) = 0;
 };
@@ -1,18 +1,18 @@
 class SetCommand : public Command                 //classe per comando SET    MODIFICATA
 {
-    int checkArgs(const std::vector<std::string>& args) override 
+    int checkArgs(const std::vector<Token>& args) override 
     {
-        if(args.size() > 3) return -1;
-        if(args[0] == "time" && args.size() == 2) return 1;
-        if(dm.checkList(args) && args.size == 2)
+        if(args.empty() || args.size() > 3) return -1;
+        if(args[0].text == "time" && args.size() == 2) return 1;
+        if(args[0].device != INVALID_DEVICE && args.size() == 2)
         {
-            if(args[1]=="on" || args[1]=="off") return 2;
+            if(args[1].text=="on" || args[1].text=="off") return 2;
             else return 3;
         }
         else return -1;
     }
 public:
-    void execute(const std::vector<std::string>& args) override
+    void execute(const std::vector<Token>& args) override
     {
         switch(checkArgs(args))
           {
@@ -34,13 +34,13 @@ public:
 
 class RmCommand : public Command                //classe per comando REMOVE        MODIFICATA
 {
-    int checkArgs(const std::vector<std::string>& args) override            //member function per verificare gli argomenti e segnalare la funzione corretta da chiamare
+    int checkArgs(const std::vector<Token>& args) override            //member function per verificare gli argomenti e segnalare la funzione corretta da chiamare
     {
-        if(dm.checkList(args))    return 1;
+        if(args.size() == 1 && args[0].device != INVALID_DEVICE)    return 1;
         else return -1;
     }
 public:
-    void execute(const std::vector<std::string>& args) override
+    void execute(const std::vector<Token>& args) override
     {
         switch(checkArgs(args))
             {
@@ -56,23 +56,71 @@ public:
 
 class ShowCommand : public Command             //classe per comando SHOW        MODIFICATA
 {
-    int checkArgs(const std::vector<std::string>& args) override 
+    struct Argomenti                              //valori letti dagli argomenti, locali a ogni esecuzione
+    {
+        std::size_t quanti = 0;                   //argomento di "show top N"
+        double soglia = 0.0;                      //argomento di "show over <kWh>"
+        int da = 0, a = 0;                        //finestra di "show [<dispositivo>] HH:MM HH:MM"
+    };
+
+    static bool isNumber(const std::string& text, std::size_t& value)
+    {
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return ec == std::errc() && end == text.data() + text.size();
+    }
+    static bool isNumber(const std::string& text, double& value)
+    {
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return ec == std::errc() && end == text.data() + text.size();
+    }
+    static bool isTime(const std::string& text, int& minutes, bool fineGiornata = false)      //fineGiornata: accetta anche 24:00
+    {
+        const char* last = text.data() + text.size();
+        const char* next = last;
+        minutes = parseClock(text.data(), last, &next, fineGiornata);
+        return minutes >= 0 && next == last;
+    }
+
+    static int parse(const std::vector<Token>& args, Argomenti& v)
     {
         if(args.empty()) return 1;
-        if(dm.checkList(args)) return 2;
+        if(args[0].device != INVALID_DEVICE && args.size() == 1) return 2;
+        if(args[0].device != INVALID_DEVICE && args.size() == 3 && isTime(args[1].text, v.da) && isTime(args[2].text, v.a, true)) return 5;
+        if(args.size() == 2 && isTime(args[0].text, v.da) && isTime(args[1].text, v.a, true)) return 6;
+        if(args.size() == 2 && args[0].text == "top" && isNumber(args[1].text, v.quanti)) return 3;
+        if(args.size() == 2 && args[0].text == "over" && isNumber(args[1].text, v.soglia)) return 4;
         else return -1;
     }
+
+    int checkArgs(const std::vector<Token>& args) override      //solo la verifica: nessuno stato nel comando
+    {
+        Argomenti v;
+        return parse(args, v);
+    }
 public:
-    void execute(const std::vector<std::string>& args) override 
+    void execute(const std::vector<Token>& args) override 
     {
-        switch(checkArgs(args))
+        Argomenti v;
+        switch(parse(args, v))
             {
                 case 1:
-                    dm.showConsumption();
+                    dm.showConsumption(out, tm.getCurrentMinutes());
                     break;
                 case 2:
                     dm.printDeviceConsumption();
                     break;
+                case 3:
+                    dm.showTopConsumers(out, v.quanti, tm.getCurrentMinutes());      //dalla storia delle accensioni, anche i dispositivi spenti
+                    break;
+                case 4:
+                    dm.showConsumersOver(out, v.soglia, tm.getCurrentMinutes());
+                    break;
+                case 5:
+                    dm.showEnergyBetween(out, args[0].device, v.da, v.a);         //ricerca binaria nella storia delle accensioni
+                    break;
+                case 6:
+                    dm.showEnergyBetween(out, INVALID_DEVICE, v.da, v.a);         //tutta la casa
+                    break;
                 case -1;
                     printInvalid();
                     break;
@@ -83,23 +131,23 @@ public:
 
 class ResetCommand : public Command         //classe per comando RESET            MODIFICATA
 {
-    int checkArgs(const std::vector<std::string>& args) override 
+    int checkArgs(const std::vector<Token>& args) override 
     {
-        if(args.size==1)
+        if(args.size()==1)
         {
-            if(args[0]=="time") return 1;
-            if(args[0]=="timers") return 2;
-            if(args[0]=="all") return 3;
-            else return -1;
+            if(args[0].text=="time") return 1;
+            if(args[0].text=="timers") return 2;
+            if(args[0].text=="all") return 3;
         }
+        return -1;
     }
 public:
-    void execute(const std::vector<std::string>& args) override 
+    void execute(const std::vector<Token>& args) override 
     {
         switch(checkArgs(args))
             {
                 case 1:
-                    dm.resetTime();
+                    tm.resetTime();                 //anche il DeviceManager apre un nuovo giorno
                     break;
                 case 2:
                     dm.resetTimers();
@@ -114,3 +162,51 @@ public:
     }
 }; 
 
+
+class LsCommand : public Command            //classe per comando LS: elenco dei dispositivi per prefisso
+{
+    int checkArgs(const std::vector<Token>& args) override 
+    {
+        if(args.empty()) return 1;
+        if(args.size()==1) return 2;
+        else return -1;
+    }
+public:
+    void execute(const std::vector<Token>& args) override 
+    {
+        switch(checkArgs(args))
+            {
+                case 1:
+                    for(const auto& nome : dm.listDevices("")) out<<nome<<'\n';
+                    break;
+                case 2:
+                    for(const auto& nome : dm.listDevices(args[0].text)) out<<nome<<'\n';
+                    break;
+                case -1:
+                    printInvalid();
+                    break;
+            }
+    }
+};
+
+class MemCommand : public Command           //classe per comando MEM: memoria occupata per dispositivo e per timer
+{
+    int checkArgs(const std::vector<Token>& args) override 
+    {
+        if(args.empty()) return 1;
+        else return -1;
+    }
+public:
+    void execute(const std::vector<Token>& args) override 
+    {
+        switch(checkArgs(args))
+            {
+                case 1:
+                    dm.showMemory(out);
+                    break;
+                case -1:
+                    printInvalid();
+                    break;
+            }
+    }
+};
@@ -0,0 +1,84 @@
+//client minimale per HomeManager --serve: invia i comandi letti da stdin e stampa le risposte
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+int main(int argc, char* argv[]) 
+{
+    if (argc < 2)
+    {
+        std::cerr<<"Uso: homeclient <socket> [ripetizioni] < comandi\n";
+        return 2;
+    }
+    long ripetizioni = argc >= 3 ? std::stol(argv[2]) : 1;      //per i test di carico lo script viene ripetuto
+    
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, argv[1], sizeof(address.sun_path) - 1);
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+    {
+        std::cerr<<"Impossibile connettersi a "<<argv[1]<<": "<<std::strerror(errno)<<"\n";
+        return 1;
+    }
+    
+    std::string script;
+    std::string line;
+    long comandi = 0;
+    while (std::getline(std::cin, line))
+    {
+        script += line;
+        script += '\n';
+        comandi++;
+    }
+    
+    auto inizio = std::chrono::steady_clock::now();
+    
+    //i comandi vengono inviati in pipeline da un processo figlio, mentre il padre legge le risposte
+    if (fork() == 0)
+    {
+        for (long r = 0; r < ripetizioni; r++)
+        {
+            std::size_t inviati = 0;
+            while (inviati < script.size())
+            {
+                ssize_t n = write(fd, script.data() + inviati, script.size() - inviati);
+                if (n <= 0) _exit(1);
+                inviati += n;
+            }
+        }
+        shutdown(fd, SHUT_WR);
+        _exit(0);
+    }
+    
+    long risposte = 0;
+    char buffer[64 * 1024];
+    std::string resto;
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0)
+    {
+        if (ripetizioni == 1) std::cout.write(buffer, n);
+        resto.append(buffer, n);
+        std::size_t pos = 0;
+        std::size_t fine;
+        while ((fine = resto.find(".\n", pos)) != std::string::npos)           //ogni risposta termina con una riga "."
+        {
+            if (fine == 0 || resto[fine - 1] == '\n') risposte++;
+            pos = fine + 2;
+        }
+        resto.erase(0, pos);
+    }
+    close(fd);
+    wait(nullptr);
+    
+    double secondi = std::chrono::duration<double>(std::chrono::steady_clock::now() - inizio).count();
+    std::cerr<<risposte<<" risposte su "<<comandi * ripetizioni<<" comandi, "<<(secondi > 0 ? risposte / secondi : 0)<<" comandi/s\n";
+    return 0;
+}
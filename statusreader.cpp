@@ -0,0 +1,81 @@
+//lettore della pagina di stato pubblicata da HomeManager --status <nome>: nessuna syscall per lettura
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include "statuspage.h"
+
+int main(int argc, char* argv[]) 
+{
+    if (argc < 2)
+    {
+        std::cerr<<"Uso: statusreader <nome shm> [intervallo ms]\n";
+        return 2;
+    }
+    int intervallo = argc >= 3 ? std::stoi(argv[2]) : 0;        //0: una sola lettura
+    
+    int fd = shm_open(argv[1], O_RDONLY, 0);
+    if (fd < 0)
+    {
+        std::cerr<<"Pagina di stato "<<argv[1]<<" non trovata: "<<std::strerror(errno)<<"\n";
+        return 1;
+    }
+    
+    //prima mappa solo l'intestazione per conoscere la capacita', poi tutta la pagina;
+    //se il simulatore la allarga (nuovi dispositivi) la pagina viene rimappata
+    void* memoria = mmap(nullptr, sizeof(StatusHeader), PROT_READ, MAP_SHARED, fd, 0);
+    if (memoria == MAP_FAILED)
+    {
+        std::cerr<<"mmap: "<<std::strerror(errno)<<"\n";
+        return 1;
+    }
+    std::uint32_t capacita = 0;
+    std::size_t dimensione = sizeof(StatusHeader);
+    const StatusHeader* pagina = static_cast<const StatusHeader*>(memoria);
+    if (pagina->magic != STATUS_PAGE_MAGIC || pagina->version != STATUS_PAGE_VERSION)
+    {
+        std::cerr<<"Formato della pagina di stato non riconosciuto\n";
+        return 1;
+    }
+    
+    StatusHeader stato{};
+    std::vector<std::uint64_t> bit;
+    while (true)
+    {
+        readStatus(pagina, stato, bit.data(), capacita);
+        if (stato.deviceCapacity > capacita)        //pagina cresciuta: rimappa e rileggi
+        {
+            munmap(memoria, dimensione);
+            capacita = stato.deviceCapacity;
+            dimensione = statusPageSize(capacita);
+            memoria = mmap(nullptr, dimensione, PROT_READ, MAP_SHARED, fd, 0);
+            if (memoria == MAP_FAILED)
+            {
+                std::cerr<<"mmap: "<<std::strerror(errno)<<"\n";
+                return 1;
+            }
+            pagina = static_cast<const StatusHeader*>(memoria);
+            bit.assign((capacita + 63) / 64, 0);
+            continue;
+        }
+        
+        std::size_t accesi = 0;
+        for (std::uint64_t parola : bit) accesi += __builtin_popcountll(parola);
+        
+        std::cout<<"Ora: "<<stato.currentMinute / 60<<":"<<(stato.currentMinute % 60 < 10 ? "0" : "")<<stato.currentMinute % 60
+                 <<"  rete: "<<stato.gridDrawKw<<" kW  fotovoltaico: "<<stato.photovoltaicKw<<" kW  batteria: "<<stato.batteryKw<<" kW"
+                 <<"  consumati: "<<stato.consumedKwh<<" kWh  prodotti: "<<stato.producedKwh<<" kWh"
+                 <<"  accesi: "<<accesi<<(stato.flags & STATUS_OVERFLOW ? " (incompleto)" : "")
+                 <<"  distacchi: "<<stato.shedCount<<"\n";
+        
+        if (intervallo <= 0) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervallo));
+    }
+    
+    munmap(memoria, dimensione);
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,34 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+
+// Misure dei benchmark: f() viene ripetuta finche' non passano almeno
+// minSeconds, e il risultato e' il tempo medio per operazione (ogni chiamata
+// di f ne esegue operations). Stampa "nome: x ns/op" e restituisce i ns/op.
+template <typename F>
+double measure(const char* name, std::size_t operations, F&& f, double minSeconds = 0.3) {
+    using Clock = std::chrono::steady_clock;
+    f();                                            // Riscaldamento (cache, allocazioni iniziali)
+    std::size_t calls = 0;
+    auto start = Clock::now();
+    double elapsed = 0.0;
+    do {
+        f();
+        calls++;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < minSeconds);
+    double nsPerOp = elapsed * 1e9 / (static_cast<double>(calls) * operations);
+    std::printf("%-48s %10.2f ns/op\n", name, nsPerOp);
+    return nsPerOp;
+}
+
+// Impedisce al compilatore di eliminare un calcolo il cui risultato non e' usato
+template <typename T>
+inline void keep(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+#endif // BENCH_H
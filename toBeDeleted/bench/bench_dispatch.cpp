@@ -0,0 +1,167 @@
+// Dispatch dei dispositivi nei cicli caldi (distacco dei carichi e tick):
+// gerarchia virtuale storica contro std::variant (AnyDevice), sugli stessi
+// dispositivi, e poi i due cicli completi del DeviceManager.
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "device_manager.h"
+
+// Copia della gerarchia virtuale originale: stessi metodi virtuali, un
+// oggetto sull'heap per dispositivo tenuto da shared_ptr
+namespace storico {
+
+class Device {
+protected:
+    std::string name;
+    std::string id;
+    double power;
+    bool isOn = false;
+    int priority;
+
+public:
+    Device(const std::string& name, const std::string& id, double power, int priority)
+        : name(name), id(id), power(power), priority(priority) {}
+    virtual ~Device() = default;
+    virtual void turnOn() = 0;
+    virtual void turnOff() = 0;
+    virtual bool canBeTurnedOff() const = 0;
+    double getPower() const { return power; }
+    bool isActive() const { return isOn; }
+};
+
+class ManualDevice : public Device {
+    bool canBeForceOff;
+
+public:
+    ManualDevice(const std::string& name, const std::string& id, double power, int priority, bool canBeForceOff)
+        : Device(name, id, power, priority), canBeForceOff(canBeForceOff) {}
+    void turnOn() override { isOn = true; }
+    void turnOff() override { isOn = false; }
+    bool canBeTurnedOff() const override { return canBeForceOff; }
+};
+
+class AutoDevice : public Device {
+    int durationMinutes;
+    int startTimeMinute = 0;
+    bool cycleInProgress = false;
+
+public:
+    AutoDevice(const std::string& name, const std::string& id, double power, int priority, int durationMinutes)
+        : Device(name, id, power, priority), durationMinutes(durationMinutes) {}
+    void turnOn() override { isOn = true; cycleInProgress = true; }
+    void turnOff() override { isOn = false; cycleInProgress = false; }
+    bool canBeTurnedOff() const override { return true; }
+    void setStartTime(int minute) { startTimeMinute = minute; }
+    bool shouldTurnOff(int minute) const { return cycleInProgress && minute - startTimeMinute >= durationMinutes; }
+};
+
+}  // namespace storico
+
+int main() {
+    constexpr std::size_t N = 100000;
+    std::mt19937 random(42);
+
+    std::vector<std::shared_ptr<storico::Device>> virtuali;
+    std::vector<AnyDevice> varianti;
+    virtuali.reserve(N);
+    varianti.reserve(N);
+    for (std::size_t i = 0; i < N; i++) {
+        double power = -0.1 - (random() % 2000) / 1000.0;
+        int priority = random() % 10;
+        bool automatic = random() % 3 == 0;
+        int start = random() % 600;
+        std::string id = "d" + std::to_string(i);
+        if (automatic) {
+            auto device = std::make_shared<storico::AutoDevice>(id, id, power, priority, 30 + random() % 90);
+            device->turnOn();
+            device->setStartTime(start);
+            virtuali.push_back(device);
+            varianti.emplace_back(std::in_place_type<AutoDevice>, power, priority, 30 + random() % 90);
+            turnOn(varianti.back(), start);
+        } else {
+            bool forceOff = random() % 4 != 0;
+            virtuali.push_back(std::make_shared<storico::ManualDevice>(id, id, power, priority, forceOff));
+            varianti.emplace_back(std::in_place_type<ManualDevice>, power, priority, forceOff);
+            if (random() % 2) {
+                virtuali.back()->turnOn();
+                turnOn(varianti.back(), 0);
+            }
+        }
+    }
+
+    // Scansione del distacco: potenza dei dispositivi accesi che si possono spegnere
+    double virtualShed = measure("distacco, scansione (virtuale)", N, [&] {
+        double load = 0.0;
+        for (const auto& device : virtuali) {
+            if (device->isActive() && device->canBeTurnedOff()) load += device->getPower();
+        }
+        keep(load);
+    });
+    double variantShed = measure("distacco, scansione (variant)", N, [&] {
+        double load = 0.0;
+        for (const auto& device : varianti) {
+            if (asDevice(device).isActive() && canBeTurnedOff(device)) load += asDevice(device).getPower();
+        }
+        keep(load);
+    });
+
+    // Tick: scadenza dei cicli automatici
+    double virtualTick = measure("tick, scadenza dei cicli (virtuale)", N, [&] {
+        std::size_t expired = 0;
+        for (const auto& device : virtuali) {
+            auto automatic = std::dynamic_pointer_cast<storico::AutoDevice>(device);
+            if (automatic && automatic->shouldTurnOff(600)) expired++;
+        }
+        keep(expired);
+    });
+    double variantTick = measure("tick, scadenza dei cicli (variant)", N, [&] {
+        std::size_t expired = 0;
+        for (const auto& device : varianti) {
+            const auto* automatic = std::get_if<AutoDevice>(&device);
+            if (automatic && automatic->shouldTurnOff(600)) expired++;
+        }
+        keep(expired);
+    });
+    std::printf("accelerazione: distacco %.1fx, tick %.1fx\n\n", virtualShed / variantShed, virtualTick / variantTick);
+
+    // Cicli completi del DeviceManager. Distacco: ogni accensione di un carico
+    // ad alta priorita' fa spegnere un carico a bassa priorita'
+    {
+        DeviceManager dm(1000.0);
+        std::vector<DeviceHandle> low, high;
+        for (std::size_t i = 0; i < 1000; i++) {
+            low.push_back(dm.addDevice<ManualDevice>("L", "low" + std::to_string(i), -1.0, 1));
+            dm.turnOnDevice(low.back(), 0);
+        }
+        for (std::size_t i = 0; i < 1000; i++) {
+            high.push_back(dm.addDevice<ManualDevice>("H", "high" + std::to_string(i), -1.0, 5));
+        }
+        std::size_t next = 0;
+        measure("DeviceManager: accensione con un distacco", 1, [&] {
+            std::size_t i = next++ % high.size();
+            dm.turnOffDevice(high[i]);
+            dm.turnOnDevice(low[i], 0);         // Riporta il carico al limite...
+            dm.turnOnDevice(high[i], 0);        // ...e l'accensione ne distacca uno
+        });
+    }
+
+    // Tick: 100k dispositivi, un quarto con un timer, cicli automatici di 30 minuti
+    {
+        DeviceManager dm(1e6);
+        for (std::size_t i = 0; i < N; i++) {
+            std::string id = "dev" + std::to_string(i);
+            DeviceHandle handle = i % 3 ? dm.addDevice<ManualDevice>("D", id, -0.1, i % 10)
+                                        : dm.addDevice<AutoDevice>("D", id, -0.1, i % 10, 30);
+            if (i % 4 == 0) dm.addTimer(handle, static_cast<int>(1 + i % 1400));
+        }
+        int minute = 0;
+        measure("DeviceManager: tick, 100k dispositivi", 1, [&] {
+            minute = minute % (MINUTES_PER_DAY - 1) + 1;
+            dm.checkAndUpdateDevices(minute);
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+// Lettura e scrittura degli orari e report "show": versioni originali con
+// gli stream contro parseClock / OutputBuffer.
+
+#include <fcntl.h>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "time_manager.h"
+
+// Conversioni originali di TimeManager, con gli stream
+static int streamParse(const std::string& timeStr) {
+    int hours, minutes;
+    char delimiter;
+    std::istringstream ss(timeStr);
+    ss >> hours >> delimiter >> minutes;
+    if (ss.fail() || delimiter != ':' || hours < 0 || hours > 23 || minutes < 0 || minutes > 59) {
+        throw std::invalid_argument("Invalid time format. Use HH:MM (24h format)");
+    }
+    return hours * 60 + minutes;
+}
+
+static std::string streamFormat(int minutes) {
+    std::ostringstream ss;
+    ss << std::setfill('0') << std::setw(2) << minutes / 60 << ":"
+       << std::setfill('0') << std::setw(2) << minutes % 60;
+    return ss.str();
+}
+
+int main() {
+    std::vector<std::string> times;
+    for (int m = 0; m < MINUTES_PER_DAY; m++) {
+        OutputBuffer text(-1);
+        text.time(m);
+        times.emplace_back(text.view());
+    }
+
+    double streamIn = measure("parse HH:MM (istringstream)", times.size(), [&] {
+        int sum = 0;
+        for (const auto& time : times) sum += streamParse(time);
+        keep(sum);
+    });
+    double charsIn = measure("parse HH:MM (parseClock)", times.size(), [&] {
+        int sum = 0;
+        for (const auto& time : times) sum += TimeManager::convertTimeToMinutes(time);
+        keep(sum);
+    });
+
+    double streamOut = measure("format HH:MM (ostringstream)", MINUTES_PER_DAY, [&] {
+        std::size_t length = 0;
+        for (int m = 0; m < MINUTES_PER_DAY; m++) length += streamFormat(m).size();
+        keep(length);
+    });
+    OutputBuffer formatted(-1);
+    double charsOut = measure("format HH:MM (OutputBuffer)", MINUTES_PER_DAY, [&] {
+        formatted.clear();
+        for (int m = 0; m < MINUTES_PER_DAY; m++) formatted.time(m);
+        keep(formatted.view().size());
+    });
+    std::printf("accelerazione: parse %.1fx, format %.1fx\n\n", streamIn / charsIn, streamOut / charsOut);
+
+    // Report "show" di 5000 dispositivi accesi, scritto su /dev/null
+    constexpr int DEVICES = 5000;
+    DeviceManager dm(1e6);
+    for (int i = 0; i < DEVICES; i++) {
+        DeviceHandle handle = dm.addDevice<ManualDevice>("D", "dispositivo" + std::to_string(i), -0.5 - i % 7 * 0.1, 1);
+        dm.turnOnDevice(handle, 0);
+    }
+    std::ofstream devNull("/dev/null");
+    const auto& report = dm.getAllDevicesEnergy(600);
+    double streamShow = measure("show, 5000 righe (ostream per campo)", DEVICES, [&] {
+        double total = 0.0;
+        for (const auto& [id, energy] : report) {
+            devNull << id << ": " << std::fixed << std::setprecision(3) << energy << " kWh" << std::endl;
+            total += energy;
+        }
+        devNull << "Totale: " << total << " kWh" << std::endl;
+    });
+    OutputBuffer out(open("/dev/null", O_WRONLY));
+    double bufferShow = measure("show, 5000 righe (OutputBuffer, una write)", DEVICES, [&] {
+        dm.showConsumption(out, 600);
+        out.flush();
+    });
+    std::printf("accelerazione: show %.1fx\n", streamShow / bufferShow);
+    return 0;
+}
@@ -0,0 +1,103 @@
+// Script compilati contro l'interprete: la stessa giornata di comandi eseguita
+// con runScript su un CompiledScript (compilato una volta) e riga per riga,
+// rifacendo a ogni comando tokenizzazione, risoluzione dei nomi e controllo
+// degli argomenti come l'interprete (CommandParser vive nel file
+// dell'interprete e non si compila da solo: la riga passa da ScriptCompiler).
+// Prima controlla che i due percorsi stampino lo stesso testo (esce con 1 alla
+// differenza) e che una soglia fuori intervallo sia rifiutata.
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "device_manager.h"
+#include "time_manager.h"
+#include "scriptbytecode.h"
+
+// Una giornata di comandi: ogni ora un forno acceso e spento, una lavatrice
+// programmata, letture dei consumi
+static std::vector<std::string> dayLines() {
+    std::vector<std::string> lines = {"reset time"};
+    char line[64];
+    for (int hour = 1; hour < 24; hour++) {
+        std::snprintf(line, sizeof line, "set time %02d:00", hour);
+        lines.push_back(line);
+        lines.push_back("set \"forno\" on");
+        lines.push_back("show \"forno\"");
+        lines.push_back("set \"forno\" off");
+        std::snprintf(line, sizeof line, "set \"lavatrice\" %02d:30", hour);
+        lines.push_back(line);
+        lines.push_back("show top 3");
+        lines.push_back("show over 0.5");
+    }
+    lines.push_back("show");
+    return lines;
+}
+
+static void addHouse(DeviceManager& dm) {
+    dm.addDevice<ManualDevice>("Frigorifero", "frigo", -0.4, 5, false);
+    dm.addDevice<ManualDevice>("Forno", "forno", -2.0, 1);
+    dm.addDevice<AutoDevice>("Lavatrice", "lavatrice", -2.0, 2, 110);
+    dm.addDevice<ManualDevice>("TV", "tv", -0.2, 4);
+    dm.addDevice<ManualDevice>("Fotovoltaico", "fotovoltaico", 1.5, 9);
+}
+
+// Riga per riga, come l'interprete
+static void runLines(const std::vector<std::string>& lines, DeviceManager& dm, TimeManager& tm, OutputBuffer& out) {
+    for (const std::string& line : lines) {
+        runScript(ScriptCompiler(dm).compileText(line), dm, tm, out);
+    }
+}
+
+int main() {
+    std::vector<std::string> lines = dayLines();
+    std::string text;
+    for (const std::string& line : lines) text += line + '\n';
+
+    // Verifica: i due percorsi partono dalla stessa casa appena creata
+    std::string outputs[2];
+    for (int path = 0; path < 2; path++) {
+        DeviceManager dm(6.0);
+        TimeManager tm(dm);
+        addHouse(dm);
+        OutputBuffer out(-1);
+        if (path == 0) {
+            runScript(ScriptCompiler(dm).compileText(text), dm, tm, out);
+        } else {
+            runLines(lines, dm, tm, out);
+        }
+        outputs[path] = out.view();
+    }
+    if (outputs[0] != outputs[1]) {
+        std::printf("uscite diverse:\n%s\n---\n%s\n", outputs[0].c_str(), outputs[1].c_str());
+        return 1;
+    }
+
+    DeviceManager dm(6.0);
+    TimeManager tm(dm);
+    addHouse(dm);
+    OutputBuffer out(-1);
+    CompiledScript day = ScriptCompiler(dm).compileText(text);
+    try {
+        ScriptCompiler(dm).compileText("show over 3000000");
+        std::printf("soglia fuori intervallo accettata\n");
+        return 1;
+    } catch (const std::invalid_argument&) {
+    }
+    std::printf("stessa uscita: %zu comandi, %zu byte\n\n", lines.size(), outputs[0].size());
+
+    double scripted = measure("runScript, script compilato", lines.size(), [&] {
+        out.clear();
+        runScript(day, dm, tm, out);
+    });
+    double parsed = measure("riga per riga (tokenizzazione e dispatch)", lines.size(), [&] {
+        out.clear();
+        runLines(lines, dm, tm, out);
+    });
+    measure("compilazione dello script", lines.size(), [&] {
+        keep(ScriptCompiler(dm).compileText(text).ops.size());
+    });
+    std::printf("accelerazione: %.1fx\n", parsed / scripted);
+    return 0;
+}
@@ -0,0 +1,127 @@
+// Throughput del server a socket Unix con un client che invia i comandi in
+// pipeline: prima con un gestore che risponde subito (solo il trasporto), poi
+// eseguendo davvero i comandi sul DeviceManager. CommandParser vive nel file
+// dell'interprete e non si compila da solo: qui ogni riga fa lo stesso
+// percorso con ScriptCompiler (tokenizzazione, risoluzione dei nomi, controllo
+// degli argomenti) e runScript, con l'uscita in un OutputBuffer.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "bench.h"
+#include "commandserver.h"
+#include "scriptbytecode.h"
+
+// Una giornata di comandi: ogni ora un forno acceso e spento, una lavatrice
+// programmata, letture dei consumi
+static std::string dayScript(std::size_t& commands) {
+    std::string script = "reset time\n";
+    commands = 1;
+    char line[64];
+    for (int hour = 1; hour < 24; hour++) {
+        std::snprintf(line, sizeof line, "set time %02d:00\n", hour);
+        script += line;
+        script += "set \"forno\" on\nshow \"forno\"\nset \"forno\" off\n";
+        std::snprintf(line, sizeof line, "set \"lavatrice\" %02d:30\n", hour);
+        script += line;
+        script += "show top 3\n";
+        commands += 6;
+    }
+    script += "show\n";
+    commands++;
+    return script + "stop\n";
+}
+
+// Invia lo script in pipeline e aspetta tutte le risposte; restituisce i comandi al secondo.
+// Il server si chiude prima di aspettare il client: se mancasse una risposta il
+// client vedrebbe la fine del socket invece di restare in attesa
+template <typename Handler>
+static double serve(const char* name, const std::string& path, const std::string& day, std::size_t commands,
+                    int days, Handler handler) {
+    auto server = std::make_unique<CommandServer>(path);
+    double seconds = 0.0;
+    std::size_t replies = 0;
+    std::thread client([&]() {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) std::abort();
+
+        std::string body = day.substr(0, day.size() - 5);           // Senza "stop"
+        auto start = std::chrono::steady_clock::now();
+        std::thread writer([&]() {
+            for (int d = 0; d < days; d++) {
+                const std::string& text = d + 1 < days ? body : day;
+                for (std::size_t sent = 0; sent < text.size();) {
+                    ssize_t n = ::send(fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+                    if (n <= 0) std::abort();
+                    sent += static_cast<std::size_t>(n);
+                }
+            }
+        });
+        std::size_t expected = commands * days + 1;
+        char buffer[64 * 1024];
+        enum { MID_LINE, LINE_START, DOT } state = LINE_START;     // Una riga "." puo' cadere tra due letture
+        while (replies < expected) {
+            ssize_t n = ::read(fd, buffer, sizeof(buffer));
+            if (n <= 0) break;
+            for (ssize_t i = 0; i < n; i++) {
+                if (state == DOT && buffer[i] == '\n') replies++;
+                state = buffer[i] == '\n' ? LINE_START : state == LINE_START && buffer[i] == '.' ? DOT : MID_LINE;
+            }
+        }
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        writer.join();
+        close(fd);
+    });
+    server->run([&](const std::string& line, std::string& reply) {
+        if (line == "stop") server->stop();
+        handler(line, reply);
+    });
+    server.reset();
+    client.join();
+    if (replies != commands * days + 1) {
+        std::printf("%s: %zu risposte su %zu\n", name, replies, commands * days + 1);
+        std::exit(1);
+    }
+    double perSecond = commands * days / seconds;
+    std::printf("%-48s %10.0f comandi/s\n", name, perSecond);
+    return perSecond;
+}
+
+int main() {
+    std::size_t commands = 0;
+    std::string day = dayScript(commands);
+    std::string path = "/tmp/bench_server." + std::to_string(getpid()) + ".sock";
+    const int days = 2000;
+
+    serve("eco (solo trasporto)", path, day, commands, days, [](const std::string& line, std::string& reply) {
+        reply += line;
+        reply += '\n';
+    });
+
+    DeviceManager dm;
+    TimeManager tm(dm);
+    OutputBuffer out(-1);
+    dm.addDevice<ManualDevice>("Forno", "forno", -2.0, 2);
+    dm.addDevice<AutoDevice>("Lavatrice", "lavatrice", -1.5, 1, 60);
+    for (int i = 0; i < 20; i++) {
+        dm.addDevice<ManualDevice>("Luce", "luce" + std::to_string(i), -0.05, 0);
+    }
+    ScriptCompiler compiler(dm);
+    serve("comandi eseguiti sul DeviceManager", path, day, commands, days, [&](const std::string& line, std::string& reply) {
+        if (line == "stop") return;
+        runScript(compiler.compileText(line), dm, tm, out);
+        reply.append(out.view());
+        out.clear();
+    });
+    return 0;
+}
@@ -0,0 +1,96 @@
+// Strategie di distacco: LowestPriorityFirst (storica) contro MinimalLossShedding
+// sugli stessi insiemi di candidati. Per ogni numero di candidati si misura il
+// tempo di una select() e si confronta la perdita pesata (priorita' + 1) * kW
+// e i kW spenti, mediati su molti scenari casuali.
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "bench.h"
+#include "sheddingstrategy.h"
+
+struct Scenario {
+    std::vector<SheddingCandidate> candidates;    // In ordine di priorita' crescente
+    double excessKw;
+};
+
+// Candidati con potenze da 0.1 a 3 kW e priorita' 0..9; l'eccesso e' una
+// frazione casuale (5%..40%) della potenza spegnibile
+static std::vector<Scenario> makeScenarios(std::size_t candidates, std::size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> load(0.1, 3.0);
+    std::uniform_int_distribution<int> priority(0, 9);
+    std::uniform_real_distribution<double> fraction(0.05, 0.40);
+    std::vector<Scenario> scenarios(count);
+    for (auto& scenario : scenarios) {
+        double total = 0.0;
+        for (std::size_t i = 0; i < candidates; i++) {
+            SheddingCandidate candidate{static_cast<DeviceHandle>(i), priority(rng), load(rng)};
+            total += candidate.load;
+            scenario.candidates.push_back(candidate);
+        }
+        std::stable_sort(scenario.candidates.begin(), scenario.candidates.end(),
+                         [](const SheddingCandidate& a, const SheddingCandidate& b) { return a.priority < b.priority; });
+        scenario.excessKw = total * fraction(rng);
+    }
+    return scenarios;
+}
+
+struct Outcome {
+    double loss = 0.0;
+    double shedKw = 0.0;
+    double devices = 0.0;
+};
+
+// Perdita e potenza spenta medie di una strategia sugli scenari
+static Outcome evaluate(SheddingStrategy& strategy, const std::vector<Scenario>& scenarios) {
+    Outcome outcome;
+    std::vector<DeviceHandle> toShed;
+    for (const auto& scenario : scenarios) {
+        toShed.clear();
+        strategy.select(scenario.candidates, scenario.excessKw, toShed);
+        for (DeviceHandle handle : toShed) {
+            const auto& candidate = *std::find_if(scenario.candidates.begin(), scenario.candidates.end(),
+                                                  [&](const SheddingCandidate& c) { return c.device == handle; });
+            outcome.loss += (candidate.priority + 1) * candidate.load;
+            outcome.shedKw += candidate.load;
+        }
+        outcome.devices += static_cast<double>(toShed.size());
+    }
+    outcome.loss /= scenarios.size();
+    outcome.shedKw /= scenarios.size();
+    outcome.devices /= scenarios.size();
+    return outcome;
+}
+
+int main() {
+    for (std::size_t size : {10u, 100u, 500u, 2000u}) {
+        auto scenarios = makeScenarios(size, 64, 7u + static_cast<unsigned>(size));
+        LowestPriorityFirst lowest;
+        MinimalLossShedding minimal;
+        std::vector<DeviceHandle> toShed;
+        char name[64];
+
+        std::snprintf(name, sizeof name, "LowestPriorityFirst  %4zu candidati", size);
+        measure(name, scenarios.size(), [&] {
+            for (const auto& scenario : scenarios) {
+                toShed.clear();
+                keep(lowest.select(scenario.candidates, scenario.excessKw, toShed));
+            }
+        });
+        std::snprintf(name, sizeof name, "MinimalLossShedding  %4zu candidati", size);
+        measure(name, scenarios.size(), [&] {
+            for (const auto& scenario : scenarios) {
+                toShed.clear();
+                keep(minimal.select(scenario.candidates, scenario.excessKw, toShed));
+            }
+        });
+
+        Outcome a = evaluate(lowest, scenarios);
+        Outcome b = evaluate(minimal, scenarios);
+        std::printf("  perdita pesata  %10.1f -> %10.1f (%.1f%% in meno)\n", a.loss, b.loss, 100.0 * (a.loss - b.loss) / a.loss);
+        std::printf("  kW spenti       %10.2f -> %10.2f, dispositivi %.1f -> %.1f\n", a.shedKw, b.shedKw, a.devices, b.devices);
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+// Casa a configurazione fissa (StaticHousehold) contro DeviceManager: prima la
+// verifica che le due simulazioni diano gli stessi stati e gli stessi distacchi
+// minuto per minuto su programmi di timer casuali (esce con 1 alla prima
+// differenza), poi la risoluzione dei nomi e il tick a confronto. L'elenco
+// grande (1000 ID) controlla anche che l'hash perfetto si costruisca a
+// compile time oltre le poche decine di dispositivi.
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include "bench.h"
+#include "device_manager.h"
+#include "statichousehold.h"
+
+constexpr DeviceSpec CASA[] = {
+    manualDevice("frigo", "Frigorifero", -0.4, 5, false),
+    autoDevice("lavatrice", "Lavatrice", -2.0, 2, 110),
+    autoDevice("lavastoviglie", "Lavastoviglie", -1.5, 3, 90),
+    manualDevice("forno", "Forno", -2.0, 1),
+    manualDevice("stufa", "Stufa", -1.8, 0),
+    manualDevice("fotovoltaico", "Fotovoltaico", 1.5, 9),
+    manualDevice("tv", "TV", -0.2, 4),
+    autoDevice("asciugatrice", "Asciugatrice", -1.2, 2, 60),
+};
+
+// Elenco generato: "d0000".."d0999", potenze e priorita' ripetute. Le potenze
+// sono esatte in binario: il DeviceManager confronta l'eccesso in kW con i double
+constexpr std::size_t MANY_SIZE = 1000;
+
+constexpr std::array<char, MANY_SIZE * 5> manyText() {
+    std::array<char, MANY_SIZE * 5> text{};
+    for (std::size_t i = 0; i < MANY_SIZE; i++) {
+        text[i * 5] = 'd';
+        for (std::size_t digit = 0, value = i; digit < 4; digit++, value /= 10) {
+            text[i * 5 + 4 - digit] = static_cast<char>('0' + value % 10);
+        }
+    }
+    return text;
+}
+
+constexpr std::array<char, MANY_SIZE * 5> MANY_TEXT = manyText();
+
+constexpr std::array<DeviceSpec, MANY_SIZE> manySpecs() {
+    std::array<DeviceSpec, MANY_SIZE> specs{};
+    for (std::size_t i = 0; i < MANY_SIZE; i++) {
+        std::string_view id(MANY_TEXT.data() + i * 5, 5);
+        double power = -0.25 * static_cast<double>(1 + i % 7);   // Multipli di 0.25 kW: somme esatte anche in double
+        int priority = static_cast<int>(i % 10);
+        specs[i] = i % 3 == 0 ? autoDevice(id, id, power, priority, 20 + static_cast<int>(i % 50))
+                              : manualDevice(id, id, power, priority, i % 11 != 0);
+    }
+    return specs;
+}
+
+constexpr std::array<DeviceSpec, MANY_SIZE> MANY = manySpecs();
+
+using Casa = StaticHousehold<CASA>;
+using Molti = StaticHousehold<MANY>;
+static_assert(Casa::find("forno") == 3 && Casa::find("boh") == -1 && Casa::PHOTOVOLTAIC == 5);
+static_assert(Molti::find("d0999") == 999 && Molti::find("d1000") == -1);
+
+template <const auto& Specs>
+static void addAll(DeviceManager& dm) {
+    for (const DeviceSpec& spec : Specs) {
+        if (spec.durationMinutes > 0) {
+            dm.addDevice<AutoDevice>(std::string(spec.name), std::string(spec.id), spec.powerKw, spec.priority,
+                                     spec.durationMinutes);
+        } else {
+            dm.addDevice<ManualDevice>(std::string(spec.name), std::string(spec.id), spec.powerKw, spec.priority,
+                                       spec.canBeForceOff);
+        }
+    }
+}
+
+// Una giornata con timer casuali sulle due simulazioni: false alla prima differenza
+template <const auto& Specs>
+static bool sameDay(unsigned seed, double maxPower, std::uint64_t& shed) {
+    using Household = StaticHousehold<Specs>;
+    std::mt19937 random(seed);
+    DeviceManager dm(maxPower);
+    Household household(maxPower);
+    addAll<Specs>(dm);
+    for (std::size_t i = 0; i < Household::SIZE; i++) {
+        int start = static_cast<int>(random() % 1400);
+        int stop = Specs[i].durationMinutes > 0 ? -1 : start + 1 + static_cast<int>(random() % 200);
+        if (stop >= MINUTES_PER_DAY) stop = -1;
+        if (random() % 4 != 0) {
+            dm.addTimer(std::string(Specs[i].id), start, stop);
+            household.addTimer(i, start, stop);
+        }
+    }
+
+    for (int minute = 1; minute < MINUTES_PER_DAY; minute++) {
+        bool managerFailed = false, householdFailed = false;
+        try { dm.checkAndUpdateDevices(minute); } catch (const std::exception&) { managerFailed = true; }
+        try { household.checkAndUpdateDevices(minute); } catch (const std::exception&) { householdFailed = true; }
+        if (managerFailed != householdFailed || dm.getShedCount() != household.getShedCount()) {
+            std::printf("seme %u, minuto %d: distacchi %llu contro %llu\n", seed, minute,
+                        static_cast<unsigned long long>(dm.getShedCount()),
+                        static_cast<unsigned long long>(household.getShedCount()));
+            return false;
+        }
+        for (std::size_t i = 0; i < Household::SIZE; i++) {
+            if (dm.isDeviceActive(std::string(Specs[i].id)) != household.isDeviceActive(i)) {
+                std::printf("seme %u, minuto %d: stato diverso per %s\n", seed, minute,
+                            std::string(Specs[i].id).c_str());
+                return false;
+            }
+        }
+    }
+    shed = dm.getShedCount();
+    return true;
+}
+
+int main() {
+    std::uint64_t shed = 0, totalShed = 0;
+    for (unsigned seed = 0; seed < 300; seed++) {
+        if (!sameDay<CASA>(seed, 3.5, shed)) return 1;
+        totalShed += shed;
+    }
+    for (unsigned seed = 0; seed < 5; seed++) {
+        if (!sameDay<MANY>(seed, 50.0, shed)) return 1;
+        totalShed += shed;
+    }
+    std::printf("stessi stati e distacchi del DeviceManager: 300 giornate da %zu, 5 da %zu dispositivi, "
+                "%llu distacchi\n\n", Casa::SIZE, Molti::SIZE, static_cast<unsigned long long>(totalShed));
+
+    measure("find, 1000 ID (hash perfetto)", MANY_SIZE, [&] {
+        for (const DeviceSpec& spec : MANY) keep(Molti::find(spec.id));
+    });
+    {
+        DeviceManager dm;
+        addAll<MANY>(dm);
+        std::string ids[MANY_SIZE];
+        for (std::size_t i = 0; i < MANY_SIZE; i++) ids[i] = std::string(MANY[i].id);
+        measure("findHandle, 1000 ID (DeviceManager)", MANY_SIZE, [&] {
+            for (const std::string& id : ids) keep(dm.findHandle(id));
+        });
+    }
+
+    // Tick: un quarto dei dispositivi con un timer
+    Molti household(1e6);
+    DeviceManager dm(1e6);
+    addAll<MANY>(dm);
+    for (std::size_t i = 0; i < MANY_SIZE; i += 4) {
+        household.addTimer(i, static_cast<int>(1 + i % 1400));
+        dm.addTimer(std::string(MANY[i].id), static_cast<int>(1 + i % 1400));
+    }
+    int minute = 0;
+    double fixed = measure("tick, 1000 dispositivi (StaticHousehold)", 1, [&] {
+        minute = minute % (MINUTES_PER_DAY - 1) + 1;
+        household.checkAndUpdateDevices(minute);
+    });
+    minute = 0;
+    double managed = measure("tick, 1000 dispositivi (DeviceManager)", 1, [&] {
+        minute = minute % (MINUTES_PER_DAY - 1) + 1;
+        dm.checkAndUpdateDevices(minute);
+    });
+    std::printf("rapporto: %.1fx\n", managed / fixed);
+    return 0;
+}
@@ -0,0 +1,79 @@
+// Tick del DeviceManager con la valutazione divisa su 1, 2, 4 e 8 thread
+// (--threads): prima una giornata completa per ogni numero di thread sulla
+// stessa casa, con un limite di potenza che fa distaccare dei carichi, e la
+// verifica che report e distacchi siano identici a quelli con un thread (esce
+// con 1 alla prima differenza); poi il tempo di un tick per ciascuno.
+// L'accelerazione dipende dai core disponibili, stampati in testa.
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include "bench.h"
+#include "device_manager.h"
+
+constexpr std::size_t N = 100000;
+constexpr unsigned THREADS[] = {1, 2, 4, 8};
+
+// Un quarto dei dispositivi con un timer, un terzo automatici con cicli da 30 a 89 minuti
+static std::unique_ptr<DeviceManager> makeHouse(unsigned threads) {
+    std::unique_ptr<DeviceManager> dm(new DeviceManager(150.0));
+    dm->setTickThreads(threads);
+    for (std::size_t i = 0; i < N; i++) {
+        std::string id = "dev" + std::to_string(i);
+        int priority = static_cast<int>(i % 10);
+        DeviceHandle handle = i % 3 ? dm->addDevice<ManualDevice>("D", id, -0.1, priority)
+                                    : dm->addDevice<AutoDevice>("D", id, -0.1, priority, 30 + static_cast<int>(i % 60));
+        if (i % 4 == 0) {
+            int start = static_cast<int>(1 + i % 1400);
+            int stop = i % 3 ? std::min(start + 1 + static_cast<int>(i % 240), MINUTES_PER_DAY - 1) : -1;
+            dm->addTimer(handle, start, stop);
+        }
+    }
+    return dm;
+}
+
+// Report di fine giornata: consumi per dispositivo, i maggiori consumatori e i distacchi
+static std::string dayReport(DeviceManager& dm) {
+    for (int minute = 1; minute < MINUTES_PER_DAY; minute++) dm.checkAndUpdateDevices(minute);
+    OutputBuffer out(-1);
+    dm.showConsumption(out, MINUTES_PER_DAY - 1);
+    dm.showTopConsumers(out, 100, MINUTES_PER_DAY - 1);
+    out << "distacchi: " << static_cast<long long>(dm.getShedCount()) << '\n';
+    return std::string(out.view());
+}
+
+int main() {
+    std::string reference;
+    for (unsigned threads : THREADS) {
+        std::string report = dayReport(*makeHouse(threads));
+        if (threads == 1) {
+            reference = report;
+        } else if (report != reference) {
+            std::printf("report diverso con %u thread\n", threads);
+            return 1;
+        }
+    }
+    std::printf("stessi report con 1, 2, 4 e 8 thread: %zu byte, %s", reference.size(),
+                reference.substr(reference.rfind("distacchi")).c_str());
+    std::printf("core disponibili: %u\n\n", std::thread::hardware_concurrency());
+
+    double single = 0.0;
+    for (unsigned threads : THREADS) {
+        std::unique_ptr<DeviceManager> dm = makeHouse(threads);
+        char name[64];
+        std::snprintf(name, sizeof name, "tick, 100k dispositivi, %u thread", threads);
+        int minute = 0;
+        double elapsed = measure(name, 1, [&] {
+            minute = minute % (MINUTES_PER_DAY - 1) + 1;
+            dm->checkAndUpdateDevices(minute);
+        });
+        if (threads == 1) {
+            single = elapsed;
+        } else {
+            std::printf("    accelerazione: %.2fx\n", single / elapsed);
+        }
+    }
+    return 0;
+}
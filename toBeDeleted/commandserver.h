@@ -0,0 +1,276 @@
+#ifndef COMMAND_SERVER_H
+#define COMMAND_SERVER_H
+
+#include <string>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Server locale su socket Unix: molti client, un solo thread di simulazione.
+// Ogni client invia righe di testo (gli stessi comandi della REPL); le righe
+// vengono eseguite nell'ordine di arrivo e le risposte di tutte le righe lette
+// in un giro vengono spedite insieme. Ogni risposta termina con una riga ".".
+// Se un client non legge le risposte, il server smette di leggere le sue righe
+// finche' quelle in attesa non scendono sotto MAX_PENDING_OUTPUT. Dopo stop()
+// non si legge e non si esegue piu' nulla, ma run() ritorna solo quando le
+// risposte gia' prodotte sono state spedite (o il loro client e' caduto).
+class CommandServer {
+private:
+    struct Client {
+        std::string in;             // Byte ricevuti non ancora consumati (righe in attesa e riga incompleta)
+        std::string out;            // Risposte in attesa di essere spedite
+        std::size_t sent = 0;       // Parte di out gia' scritta
+        bool closing = false;       // Chiudere dopo aver spedito tutto ("exit")
+        bool inputClosed = false;   // Il client ha chiuso il suo lato: non si legge piu'
+        std::uint32_t events = 0;   // Eventi registrati in epoll
+    };
+
+    int listenFd = -1;
+    int epollFd = -1;
+    std::string socketPath;
+    std::unordered_map<int, Client> clients;
+    bool running = false;
+
+    static constexpr int MAX_EVENTS = 256;
+    static constexpr std::size_t READ_CHUNK = 64 * 1024;
+    static constexpr std::size_t MAX_PENDING_OUTPUT = 1024 * 1024;   // Oltre questa soglia il client non viene letto
+    static constexpr std::size_t MAX_LINE = 64 * 1024;
+
+    static void fail(const std::string& what) {
+        throw std::runtime_error(what + ": " + std::strerror(errno));
+    }
+
+    void watch(int fd, std::uint32_t events, int op) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, op, fd, &event) < 0) fail("epoll_ctl");
+    }
+
+    void drop(int fd) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        clients.erase(fd);
+    }
+
+    void acceptAll() {
+        while (true) {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return;
+                fail("accept4");
+            }
+            Client& client = clients.emplace(fd, Client()).first->second;
+            client.events = EPOLLIN | EPOLLRDHUP;
+            watch(fd, client.events, EPOLL_CTL_ADD);
+        }
+    }
+
+    // Un client che non legge le risposte non deve far crescere la memoria del server
+    static bool throttled(const Client& client) {
+        return client.out.size() - client.sent >= MAX_PENDING_OUTPUT;
+    }
+
+    // Gli eventi sono level-triggered: si chiede la lettura solo se si leggera'
+    // davvero (altrimenti un socket chiuso a meta' o un client rallentato
+    // risveglierebbero il ciclo di continuo) e la scrittura solo con risposte in attesa
+    void updateEvents(int fd, Client& client) {
+        std::uint32_t events = 0;
+        if (running && !client.inputClosed && !client.closing && !throttled(client)) events |= EPOLLIN | EPOLLRDHUP;
+        if (client.sent < client.out.size()) events |= EPOLLOUT;
+        if (events != client.events) {
+            client.events = events;
+            watch(fd, events, EPOLL_CTL_MOD);
+        }
+    }
+
+    // Spedisce quanto possibile; false se la connessione e' caduta
+    bool flushClient(int fd, Client& client) {
+        while (client.sent < client.out.size()) {
+            // MSG_NOSIGNAL: un client sparito e' un errore di scrittura, non un SIGPIPE
+            ssize_t n = ::send(fd, client.out.data() + client.sent, client.out.size() - client.sent, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                return false;
+            }
+            client.sent += static_cast<std::size_t>(n);
+        }
+        if (client.sent == client.out.size()) {
+            client.out.clear();
+            client.sent = 0;
+        }
+        return true;
+    }
+
+    // Esegue le righe complete finche' le risposte in attesa restano sotto la soglia;
+    // true se ne ha eseguita almeno una. L'errore di un comando va solo al suo client
+    template <typename Handler>
+    bool executeLines(Client& client, Handler& handler) {
+        std::size_t start = 0;
+        std::size_t newline;
+        while (running && !client.closing && !throttled(client) && (newline = client.in.find('\n', start)) != std::string::npos) {
+            std::string line = client.in.substr(start, newline - start);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            start = newline + 1;
+
+            if (line == "exit") {
+                client.closing = true;
+                break;
+            }
+            try {
+                handler(line, client.out);
+            } catch (const std::exception& e) {
+                client.out += "Errore: ";
+                client.out += e.what();
+                client.out += '\n';
+            }
+            client.out += ".\n";
+        }
+        client.in.erase(0, start);
+
+        if (!client.closing && client.in.size() > MAX_LINE && client.in.find('\n') == std::string::npos) {
+            client.out += "Errore: riga troppo lunga\n.\n";
+            client.closing = true;
+        }
+        return start > 0;
+    }
+
+    // Legge un blocco alla volta eseguendo subito le righe complete, e smette
+    // quando le risposte in attesa superano la soglia: il resto aspetta nel socket
+    template <typename Handler>
+    void readClient(int fd, Client& client, Handler& handler) {
+        char chunk[READ_CHUNK];
+        while (running && !client.inputClosed && !client.closing && !throttled(client)) {
+            ssize_t n = ::read(fd, chunk, sizeof(chunk));
+            if (n > 0) {
+                client.in.append(chunk, static_cast<std::size_t>(n));
+                executeLines(client, handler);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            client.inputClosed = true;   // EOF o errore: le righe gia' ricevute vengono eseguite comunque
+        }
+    }
+
+    // Spedisce e, man mano che le risposte escono, esegue le righe rimaste in
+    // attesa; false se il client va chiuso (connessione caduta o lavoro finito)
+    template <typename Handler>
+    bool serveClient(int fd, Client& client, Handler& handler) {
+        do {
+            if (!flushClient(fd, client)) return false;
+        } while (!throttled(client) && executeLines(client, handler));
+
+        bool finished = client.out.empty()
+            && (!running || client.closing || (client.inputClosed && client.in.find('\n') == std::string::npos));
+        if (finished) return false;
+        updateEvents(fd, client);
+        return true;
+    }
+
+    // Dopo stop(): chiude i client senza risposte in attesa e lascia agli altri
+    // la sola scrittura; true finche' qualcuno ha ancora risposte da spedire
+    bool draining() {
+        for (auto it = clients.begin(); it != clients.end();) {
+            if (it->second.sent < it->second.out.size()) {
+                updateEvents(it->first, it->second);
+                ++it;
+            } else {
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, it->first, nullptr);
+                close(it->first);
+                it = clients.erase(it);
+            }
+        }
+        return !clients.empty();
+    }
+
+    int wait(epoll_event* events) {
+        while (true) {
+            int ready = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+            if (ready >= 0) return ready;
+            if (errno != EINTR) fail("epoll_wait");
+        }
+    }
+
+public:
+    explicit CommandServer(const std::string& path) : socketPath(path) {
+        sockaddr_un address{};
+        if (path.size() >= sizeof(address.sun_path)) {
+            throw std::invalid_argument("Socket path too long: " + path);
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) fail("socket");
+        unlink(path.c_str());
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) fail("bind");
+        if (listen(listenFd, SOMAXCONN) < 0) fail("listen");
+
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd < 0) fail("epoll_create1");
+        watch(listenFd, EPOLLIN, EPOLL_CTL_ADD);
+    }
+
+    CommandServer(const CommandServer&) = delete;
+    CommandServer& operator=(const CommandServer&) = delete;
+
+    ~CommandServer() {
+        for (const auto& [fd, client] : clients) close(fd);
+        if (epollFd >= 0) close(epollFd);
+        if (listenFd >= 0) {
+            close(listenFd);
+            unlink(socketPath.c_str());
+        }
+    }
+
+    // Ciclo principale: handler(riga, risposta) esegue un comando e accoda la risposta
+    template <typename Handler>
+    void run(Handler handler) {
+        epoll_event events[MAX_EVENTS];
+        running = true;
+        while (running) {
+            int ready = wait(events);
+            for (int i = 0; running && i < ready; i++) {
+                int fd = events[i].data.fd;
+                if (fd == listenFd) {
+                    acceptAll();
+                    continue;
+                }
+
+                auto it = clients.find(fd);
+                if (it == clients.end()) continue;
+                Client& client = it->second;
+
+                if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                    readClient(fd, client, handler);
+                }
+                if (!serveClient(fd, client, handler)) {
+                    drop(fd);
+                }
+            }
+        }
+
+        // Fermato: niente nuove connessioni, si spedisce solo cio' che e' gia' pronto
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, listenFd, nullptr);
+        while (draining()) {
+            int ready = wait(events);
+            for (int i = 0; i < ready; i++) {
+                auto it = clients.find(events[i].data.fd);
+                if (it != clients.end() && !flushClient(it->first, it->second)) drop(it->first);
+            }
+        }
+    }
+
+    // Da chiamare dal gestore (stesso thread di run): le righe non ancora eseguite si scartano
+    void stop() { running = false; }
+};
+
+#endif // COMMAND_SERVER_H
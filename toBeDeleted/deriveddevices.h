@@ -1,62 +1,70 @@
 #ifndef DERIVED_DEVICES_H
 #define DERIVED_DEVICES_H
 
+#include <cmath>
+#include <variant>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
 #include "device.h"
 
 class ManualDevice : public Device {
-private:
-    bool canBeForceOff;  // Indica se il dispositivo può essere forzatamente spento (es: frigorifero non può)
-
 public:
-    ManualDevice(const std::string& name, const std::string& id, double power, 
-                int priority, bool canBeForceOff = true)
-        : Device(name, id, power, priority), canBeForceOff(canBeForceOff) {}
+    // canBeForceOff: se il dispositivo può essere forzatamente spento (es: frigorifero non può)
+    ManualDevice(double power, int priority, bool canBeForceOff = true)
+        : Device(power, priority, canBeForceOff ? FORCE_OFF_ALLOWED : 0) {}
 
-    void turnOn() override {
-        isOn = true;
+    void turnOn() {
+        setFlag(ON, true);
     }
 
-    void turnOff() override {
-        isOn = false;
+    void turnOff() {
+        setFlag(ON, false);
     }
 
-    bool canBeTurnedOff() const override {
-        return canBeForceOff;
+    bool canBeTurnedOff() const {
+        return flags & FORCE_OFF_ALLOWED;
+    }
+
+    static constexpr bool needsAutomaticShutdown() {
+        return false;
     }
 };
 
 class AutoDevice : public Device {
 private:
-    int durationMinutes;     // Durata del ciclo in minuti
-    int startTimeMinute;     // Minuto di inizio del ciclo corrente
-    bool cycleInProgress;    // Indica se un ciclo è in corso
+    std::uint16_t durationMinutes;     // Durata del ciclo in minuti
+    std::int16_t startTimeMinute;      // Minuto di inizio del ciclo corrente (negativo: iniziato ieri)
 
 public:
-    AutoDevice(const std::string& name, const std::string& id, double power,
-              int priority, int durationMinutes)
-        : Device(name, id, power, priority), 
-          durationMinutes(durationMinutes),
-          startTimeMinute(0),
-          cycleInProgress(false) {}
-
-    void turnOn() override {
-        if (!cycleInProgress) {
-            isOn = true;
-            cycleInProgress = true;
+    AutoDevice(double power, int priority, int durationMinutes)
+        : Device(power, priority, FORCE_OFF_ALLOWED),
+          durationMinutes(toDuration(durationMinutes)),
+          startTimeMinute(0) {}
+
+    static std::uint16_t toDuration(int minutes) {
+        if (minutes < 0 || minutes > 0xFFFF) {
+            throw std::invalid_argument("Cycle duration out of range");
+        }
+        return static_cast<std::uint16_t>(minutes);
+    }
+
+    void turnOn() {
+        if (!(flags & CYCLE_IN_PROGRESS)) {
+            setFlag(ON | CYCLE_IN_PROGRESS, true);
             startTimeMinute = 0;  // Questo verrà settato dal DeviceManager con l'ora corrente
         }
     }
 
-    void turnOff() override {
-        isOn = false;
-        cycleInProgress = false;
+    void turnOff() {
+        setFlag(ON | CYCLE_IN_PROGRESS, false);
     }
 
-    bool canBeTurnedOff() const override {
+    static constexpr bool canBeTurnedOff() {
         return true;  // I dispositivi a ciclo prefissato possono sempre essere spenti
     }
 
-    bool needsAutomaticShutdown() const override {
+    static constexpr bool needsAutomaticShutdown() {
         return true;
     }
 
@@ -66,11 +74,17 @@ public:
     }
 
     void setStartTime(int currentMinute) {
-        startTimeMinute = currentMinute;
+        startTimeMinute = static_cast<std::int16_t>(currentMinute);
+    }
+
+    // Nuovo giorno dopo minutes minuti (reset dell'orario): il ciclo prosegue.
+    // L'inizio si satura a -32768 (cicli ancora in corso dopo oltre 22 giorni)
+    void shiftStartTime(int minutes) {
+        startTimeMinute = static_cast<std::int16_t>(std::max(startTimeMinute - minutes, -0x8000));
     }
 
     bool shouldTurnOff(int currentMinute) const {
-        return cycleInProgress && 
+        return (flags & CYCLE_IN_PROGRESS) && 
                (currentMinute - startTimeMinute >= durationMinutes);
     }
 
@@ -79,4 +93,96 @@ public:
     }
 };
 
+// Accumulo (batteria di casa). La potenza del Device e' il limite di scarica,
+// positiva come per un produttore; acceso significa disponibile. Quanto
+// caricare o scaricare lo decide il DeviceManager a ogni evento, e lo stato di
+// carica sta li', in forma chiusa tra un evento e l'altro. Occupa lo stesso
+// slot degli AutoDevice: capacita' e limite di carica in decine di Wh e di W
+class StorageDevice : public Device {
+private:
+    std::uint8_t efficiencyPercent;          // Rendimento di carica (energia accumulata / assorbita)
+    std::uint16_t chargeLimitDecawatts;      // Limite di carica (10 W)
+    std::uint16_t capacityDecawattHours;     // Capacita' utile (10 Wh)
+
+    static std::uint16_t inTens(double kilo) {
+        long tens = std::lround(kilo * 100.0);
+        if (tens < 0 || tens > 0xFFFF) {
+            throw std::invalid_argument("Invalid storage parameters");
+        }
+        return static_cast<std::uint16_t>(tens);
+    }
+
+    static std::uint8_t inPercent(double efficiency) {
+        long percent = std::lround(efficiency * 100.0);
+        if (percent <= 0 || percent > 100) {
+            throw std::invalid_argument("Invalid storage efficiency");
+        }
+        return static_cast<std::uint8_t>(percent);
+    }
+
+public:
+    StorageDevice(double capacityKwh, double maxChargeKw, double maxDischargeKw, double efficiency = 0.9)
+        : Device(maxDischargeKw, 0),
+          efficiencyPercent(inPercent(efficiency)),
+          chargeLimitDecawatts(inTens(maxChargeKw)),
+          capacityDecawattHours(inTens(capacityKwh)) {
+        if (capacityDecawattHours == 0 || powerWatts < 0) {
+            throw std::invalid_argument("Invalid storage parameters");
+        }
+    }
+
+    void turnOn() {
+        setFlag(ON, true);
+    }
+
+    void turnOff() {
+        setFlag(ON, false);
+    }
+
+    // Non e' un carico: non viene mai scelta dal distacco
+    static constexpr bool canBeTurnedOff() {
+        return false;
+    }
+
+    static constexpr bool needsAutomaticShutdown() {
+        return false;
+    }
+
+    double getCapacityWh() const { return capacityDecawattHours * 10.0; }
+    std::int32_t getChargeLimitWatts() const { return chargeLimitDecawatts * 10; }
+    std::int32_t getDischargeLimitWatts() const { return powerWatts; }
+    double getEfficiency() const { return efficiencyPercent / 100.0; }
+};
+
+// Insieme chiuso dei tipi di dispositivo: il dispatch avviene con std::visit,
+// che il compilatore risolve staticamente e puo' inlineare
+using AnyDevice = std::variant<ManualDevice, AutoDevice, StorageDevice>;
+static_assert(sizeof(AnyDevice) <= 16, "Uno slot dell'arena deve restare di 16 byte");
+
+inline Device& asDevice(AnyDevice& device) {
+    return std::visit([](auto& d) -> Device& { return d; }, device);
+}
+
+inline const Device& asDevice(const AnyDevice& device) {
+    return std::visit([](const auto& d) -> const Device& { return d; }, device);
+}
+
+inline bool canBeTurnedOff(const AnyDevice& device) {
+    return std::visit([](const auto& d) { return d.canBeTurnedOff(); }, device);
+}
+
+// Accende il dispositivo; per i dispositivi automatici registra anche l'inizio del ciclo
+inline void turnOn(AnyDevice& device, int currentMinute) {
+    std::visit([currentMinute](auto& d) {
+        d.turnOn();
+        if constexpr (std::decay_t<decltype(d)>::needsAutomaticShutdown()) {
+            d.setStartTime(currentMinute);
+        }
+    }, device);
+}
+
+inline void turnOff(AnyDevice& device) {
+    std::visit([](auto& d) { d.turnOff(); }, device);
+}
+
 #endif // DERIVED_DEVICES_H
@@ -1,42 +1,63 @@
 #ifndef DEVICE_H
 #define DEVICE_H
 
-#include <string>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include <stdexcept>
 
+// Parte comune a tutti i dispositivi. Non ha metodi virtuali: l'insieme dei tipi
+// concreti e' chiuso (vedi AnyDevice in derived_devices.h) e il dispatch e' statico.
+// Il layout e' compatto (8 byte): potenza in watt a virgola fissa, priorita' a
+// 16 bit e stati in un byte di flag. Nome e ID stanno nella tabella dei nomi
+// del DeviceManager, una sola copia per dispositivo.
 class Device {
 protected:
-    std::string name;
-    std::string id;
-    double power;        // in kW, negative for consumption, positive for production
-    bool isOn;
-    int priority;        // Higher number = higher priority
-    
+    enum Flags : std::uint8_t {
+        ON = 1,                  // Acceso
+        FORCE_OFF_ALLOWED = 2,   // Puo' essere spento dalla politica di potenza
+        CYCLE_IN_PROGRESS = 4    // Ciclo automatico in corso (AutoDevice)
+    };
+
+    std::int32_t powerWatts;     // negative for consumption, positive for production
+    std::int16_t priority;       // Higher number = higher priority
+    std::uint8_t flags;
+
+    Device(double powerKw, int priority, std::uint8_t flags = 0)
+        : powerWatts(toWatts(powerKw)),
+          priority(toPriority(priority)),
+          flags(flags) {}
+
+    // I campi compatti non devono troncare in silenzio: i valori fuori scala sono errori
+    static std::int32_t toWatts(double powerKw) {
+        double watts = std::round(powerKw * 1000.0);
+        if (!(std::abs(watts) <= std::numeric_limits<std::int32_t>::max())) {
+            throw std::invalid_argument("Device power out of range");
+        }
+        return static_cast<std::int32_t>(watts);
+    }
+
+    static std::int16_t toPriority(int priority) {
+        if (priority < std::numeric_limits<std::int16_t>::min() || priority > std::numeric_limits<std::int16_t>::max()) {
+            throw std::invalid_argument("Device priority out of range");
+        }
+        return static_cast<std::int16_t>(priority);
+    }
+
+    void setFlag(std::uint8_t flag, bool value) {
+        flags = value ? (flags | flag) : (flags & ~flag);
+    }
+
 public:
-    Device(const std::string& name, const std::string& id, double power, int priority)
-        : name(name), id(id), power(power), isOn(false), priority(priority) {}
-    
-    virtual ~Device() = default;
-    
-    // Pure virtual functions that derived classes must implement
-    virtual void turnOn() = 0;
-    virtual void turnOff() = 0;
-    virtual bool canBeTurnedOff() const = 0;  // Some devices might not be allowed to turn off (e.g., fridge)
-    
     // Common functionality for all devices
-    std::string getName() const { return name; }
-    std::string getId() const { return id; }
-    double getPower() const { return power; }
-    bool isActive() const { return isOn; }
+    double getPower() const { return powerWatts / 1000.0; }   // in kW
+    std::int32_t getPowerWatts() const { return powerWatts; }
+    bool isActive() const { return flags & ON; }
     int getPriority() const { return priority; }
     
     // Calculate energy consumption from start to end time (in minutes)
     double calculateEnergy(int minutes) const {
-        return isOn ? (power * minutes / 60.0) : 0.0;  // Convert minutes to hours
-    }
-    
-    // Virtual function that can be overridden if needed
-    virtual bool needsAutomaticShutdown() const {
-        return false;  // By default, devices don't need automatic shutdown
+        return isActive() ? (getPower() * minutes / 60.0) : 0.0;  // Convert minutes to hours
     }
 };
 
@@ -0,0 +1,116 @@
+#ifndef DEVICE_ARENA_H
+#define DEVICE_ARENA_H
+
+#include <new>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <variant>
+#include "derived_devices.h"
+
+// Handle a 32 bit con cui tutto il resto del sistema fa riferimento a un dispositivo
+using DeviceHandle = std::uint32_t;
+constexpr DeviceHandle INVALID_DEVICE = 0xFFFFFFFFu;
+
+// Pool di slot a dimensione fissa: ogni dispositivo vive in uno slot di un blocco
+// allocato una sola volta, invece di avere una propria allocazione sull'heap.
+// L'handle e' l'indice dello slot (l'indirizzo si ricava con una divisione per
+// una potenza di due); gli slot liberati vengono riutilizzati. Oltre allo slot,
+// ogni dispositivo costa un bit nella mappa degli slot occupati.
+class DeviceArena {
+private:
+    static constexpr DeviceHandle SLOTS_PER_BLOCK = 4096;
+
+    struct Slot {
+        alignas(AnyDevice) unsigned char bytes[sizeof(AnyDevice)];
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> blocks;   // Blocchi di slot, mai spostati in memoria
+    std::vector<std::uint64_t> live;               // Bit h = slot h occupato
+    DeviceHandle slotCount = 0;                    // Slot mai assegnati oltre questo indice
+    std::vector<DeviceHandle> freeHandles;         // Slot liberati, da riutilizzare
+
+    AnyDevice* slot(DeviceHandle handle) const {
+        return reinterpret_cast<AnyDevice*>(blocks[handle / SLOTS_PER_BLOCK][handle % SLOTS_PER_BLOCK].bytes);
+    }
+
+    void setLive(DeviceHandle handle, bool value) {
+        std::uint64_t mask = std::uint64_t(1) << (handle % 64);
+        if (value) live[handle / 64] |= mask;
+        else live[handle / 64] &= ~mask;
+    }
+
+public:
+    DeviceArena() = default;
+    DeviceArena(const DeviceArena&) = delete;
+    DeviceArena& operator=(const DeviceArena&) = delete;
+
+    ~DeviceArena() {
+        for (DeviceHandle handle = 0; handle < slotCount; handle++) {
+            if (contains(handle)) slot(handle)->~AnyDevice();
+        }
+    }
+
+    // Costruisce un dispositivo di tipo T direttamente nello slot e ne restituisce l'handle
+    template <typename T, typename... Args>
+    DeviceHandle create(Args&&... args) {
+        DeviceHandle handle;
+        if (!freeHandles.empty()) {
+            handle = freeHandles.back();
+            freeHandles.pop_back();
+        } else {
+            handle = slotCount++;
+            if (handle % SLOTS_PER_BLOCK == 0) {
+                blocks.emplace_back(new Slot[SLOTS_PER_BLOCK]);
+            }
+            if (handle % 64 == 0) {
+                live.push_back(0);
+            }
+        }
+
+        try {
+            new (slot(handle)) AnyDevice(std::in_place_type<T>, std::forward<Args>(args)...);
+        } catch (...) {
+            freeHandles.push_back(handle);      // Valori fuori scala: lo slot resta libero
+            throw;
+        }
+        setLive(handle, true);
+        return handle;
+    }
+
+    void destroy(DeviceHandle handle) {
+        if (contains(handle)) {
+            slot(handle)->~AnyDevice();
+            setLive(handle, false);
+            freeHandles.push_back(handle);
+        }
+    }
+
+    bool contains(DeviceHandle handle) const {
+        return handle < slotCount && (live[handle / 64] >> (handle % 64) & 1);
+    }
+
+    AnyDevice& operator[](DeviceHandle handle) { return *slot(handle); }
+    const AnyDevice& operator[](DeviceHandle handle) const { return *slot(handle); }
+
+    // Accesso alla parte comune (potenza, stato, priorita')
+    Device& device(DeviceHandle handle) { return asDevice(*slot(handle)); }
+    const Device& device(DeviceHandle handle) const { return asDevice(*slot(handle)); }
+
+    std::size_t size() const { return slotCount - freeHandles.size(); }
+
+    // Handle validi sono tutti < slots() (utile per dividere i dispositivi in shard)
+    DeviceHandle slots() const { return slotCount; }
+
+    // Memoria occupata (byte), per il report della memoria
+    std::size_t bytesUsed() const {
+        return blocks.size() * SLOTS_PER_BLOCK * sizeof(Slot)
+             + blocks.capacity() * sizeof(blocks[0])
+             + live.capacity() * sizeof(std::uint64_t)
+             + freeHandles.capacity() * sizeof(DeviceHandle);
+    }
+};
+
+#endif // DEVICE_ARENA_H
@@ -2,22 +2,62 @@
 #define DEVICE_MANAGER_H
 
 #include <map>
-#include <list>
+#include <array>
+#include <set>
+#include <limits>
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <string>
+#include <utility>
+#include <functional>
+#include <unordered_map>
 #include <stdexcept>
 #include <algorithm>
 #include "derived_devices.h"
+#include "devicearena.h"
+#include "devicenames.h"
+#include "nameindex.h"
+#include "outputbuffer.h"
+#include "production.h"
+#include "tariff.h"
+#include "sheddingstrategy.h"
+#include "statuspage.h"
+#include "shardworkers.h"
+#include "energytimeline.h"
+#include "reservationtable.h"
 
+// Timer compatto (8 byte): i minuti del giorno stanno in 16 bit
 struct Timer {
-    std::string deviceId;
-    int startTimeMinutes;  // Tempo di accensione in minuti dalla mezzanotte
-    int stopTimeMinutes;   // Tempo di spegnimento in minuti dalla mezzanotte (opzionale per AutoDevice)
-    bool isValid;          // Flag per indicare se il timer è ancora valido
+    static constexpr std::uint16_t NO_STOP = 0xFFFF;
 
-    Timer(const std::string& id, int start, int stop = -1)
-        : deviceId(id), startTimeMinutes(start), stopTimeMinutes(stop), isValid(true) {}
+    DeviceHandle device;                 // Handle del dispositivo nell'arena del DeviceManager
+    std::uint16_t startTimeMinutes : 15; // Tempo di accensione in minuti dalla mezzanotte
+    std::uint16_t isValid : 1;           // Flag per indicare se il timer è ancora valido
+    std::uint16_t stopTimeMinutes;       // Tempo di spegnimento (NO_STOP se assente, es. AutoDevice)
+
+    Timer(DeviceHandle device, int start, int stop = -1)
+        : device(device),
+          startTimeMinutes(static_cast<std::uint16_t>(start)),
+          isValid(1),
+          stopTimeMinutes(stop < 0 ? NO_STOP : static_cast<std::uint16_t>(stop)) {}
+};
+
+// Report della memoria occupata dal modello (comando "mem"). I contenitori a
+// nodi sono stimati: un'allocazione per elemento, arrotondata come fa malloc
+struct MemoryReport {
+    std::size_t devices = 0;
+    std::size_t timers = 0;
+    std::size_t deviceBytes = 0;      // Arena, tabella dei nomi, indice alfabetico, contabilita' per handle
+    std::size_t timerBytes = 0;       // Timer e indice per handle
+    std::size_t activeBytes = 0;      // Indici dei dispositivi accesi (per priorita', cicli in corso)
+    std::size_t historyBytes = 0;     // Storia delle accensioni (EnergyTimeline)
+    std::size_t admissionBytes = 0;   // Impegni del controllo di ammissione
+    std::size_t otherBytes = 0;       // Profili, batterie, buffer dei tick, report in cache
+
+    std::size_t totalBytes() const {
+        return deviceBytes + timerBytes + activeBytes + historyBytes + admissionBytes + otherBytes;
+    }
 };
 
 class DeviceManager {
@@ -26,184 +66,1407 @@ private:
     const double MAX_POWER_FROM_GRID;  // Potenza massima dalla rete (3.5 kW)
     
     // Contenitori principali
-    std::map<std::string, std::shared_ptr<Device>> devices;              // Tutti i dispositivi per ID
-    std::multimap<int, std::shared_ptr<Device>> activeDevices;          // Dispositivi attivi ordinati per priorità
-    std::list<Timer> timers;                                            // Lista dei timer
+    DeviceArena arena;                                                  // Memoria di tutti i dispositivi
+    DeviceNames devices;                                                // Tutti i dispositivi per ID (interning)
+    NameIndex nameIndex{devices};                                       // ID in ordine alfabetico per prefissi e suggerimenti
+    std::multimap<int, DeviceHandle> activeDevices;                     // Dispositivi attivi per priorità, poi per accensione
+    std::vector<Timer> timers;                                          // Lista dei timer (in ordine di inserimento)
+    std::vector<std::uint32_t> timerOf;                                 // Handle -> indice del suo timer (NO_TIMER se assente)
+    std::vector<DeviceHandle> activeAutos;                              // AutoDevice accesi, in ordine qualsiasi
+    std::unordered_map<DeviceHandle, std::uint32_t> activeAutoIndex;    // Handle -> posizione in activeAutos
+    std::size_t invalidTimers = 0;                                      // Timer rimossi ancora presenti nel vettore
+    static constexpr std::uint32_t NO_TIMER = 0xFFFFFFFFu;
+    DeviceHandle photovoltaic = INVALID_DEVICE;                         // Handle del "fotovoltaico", risolto all'inserimento
+    std::unordered_map<DeviceHandle, ProductionProfile> profiles;       // Profili dei produttori (nodi stabili in memoria)
+    // Somme prefisse di prezzo * profilo per ogni profilo (Tariff::savingSums), rifatte a ogni tariffa
+    std::unordered_map<DeviceHandle, std::array<double, MINUTES_PER_DAY + 1>> profileSavings;
+    const ProductionProfile* photovoltaicProfile = nullptr;             // Profilo del fotovoltaico, se caricato
+    int currentMinute = 0;                                              // Ultimo minuto simulato
+    // La storia delle accensioni usa minuti assoluti: ogni reset dell'orario apre un
+    // nuovo giorno che inizia dove il precedente si e' fermato (vedi resetTime)
+    std::vector<int> dayStarts{0};                                      // Minuto assoluto di inizio di ogni giorno
+
+    // Contabilita' dei costi: per dispositivo nella sua storia (vedi DeviceHistory),
+    // aggiornata solo alle transizioni
+    Tariff tariff;                                                      // Tariffa a fasce (nulla se non caricata)
+    bool tariffLoaded = false;
+    // Bilancio con la rete: la casa paga l'energia prelevata e incassa solo quella
+    // immessa, quindi il suo costo si calcola sulla potenza netta e non sui dispositivi
+    double gridCost = 0.0;                                              // Costo degli intervalli gia' chiusi (EUR)
+    int gridSince = 0;                                                  // Inizio dell'intervallo aperto
+
+    // Distacco dei carichi: strategia scelta per questa casa e buffer riutilizzati
+    std::unique_ptr<SheddingStrategy> shedding;
+    std::vector<SheddingCandidate> sheddingCandidates;
+    std::vector<DeviceHandle> toShed;
+
+    // Totali aggiornati alle transizioni (i produttori con profilo si sommano al tick)
+    // In watt interi: le somme incrementali restano esatte anche dopo milioni di transizioni
+    std::int64_t activeLoadWatts = 0;                                   // Consumo dei dispositivi accesi
+    std::int64_t activeFixedProductionWatts = 0;                        // Produttori accesi senza profilo
+    double consumedKwh = 0.0;
+    double producedKwh = 0.0;
+    std::uint64_t shedCount = 0;
+    std::unique_ptr<StatusPublisher> statusPage;                        // Pagina di stato condivisa (opzionale)
+
+    // Tick a shard: ogni shard propone le transizioni di una parte dei timer e
+    // degli AutoDevice accesi, poi vengono applicate tutte insieme in un ordine fisso
+    struct Transition {
+        DeviceHandle device;
+        int priority;
+        bool on;
+    };
+    std::unique_ptr<ShardWorkers> workers;                              // Nullo: tick su un solo thread
+    std::function<void(unsigned)> evaluateShard;                        // Lavoro dei worker, creato con loro
+    std::vector<std::vector<Transition>> proposals{1};                  // Una lista per shard
+    std::vector<Transition> transitions;                                // Proposte unite, in ordine
+
+    // Storia delle accensioni per le energie su finestre arbitrarie e costo degli
+    // intervalli gia' chiusi: solo i dispositivi che hanno avuto transizioni (quelli
+    // mai accesi non occupano nulla), piu' il netto dei dispositivi senza profilo
+    struct DeviceHistory {
+        EnergyTimeline timeline;
+        double closedCost = 0.0;                                        // EUR
+        int onSince = -1;                                               // Minuto di accensione (-1 se spento)
+        std::multimap<int, DeviceHandle>::iterator active;              // Posizione in activeDevices (se acceso)
+    };
+    std::unordered_map<DeviceHandle, DeviceHistory> histories;
+    EnergyTimeline householdTimeline;
+    // Produttori con profilo rimossi: la loro energia resta nel netto della casa
+    // (quelli a potenza fissa sono gia' in householdTimeline)
+    struct RetiredProducer {
+        EnergyTimeline timeline;
+        ProductionProfile profile;
+    };
+    std::vector<RetiredProducer> retiredProducers;
+    // Consumatori in ordine di energia del giorno (watt-minuto, interi ed esatti), aggiornati a
+    // ogni transizione. Quelli spenti hanno energia fissa; quelli accesi sono divisi
+    // per potenza, con chiave energia - potenza * minuto: costante finche' restano
+    // accesi, quindi a pari potenza l'ordine non cambia con il tempo
+    using ConsumerOrder = std::set<std::pair<std::int64_t, DeviceHandle>>;
+    ConsumerOrder idleConsumers;
+    std::map<std::int64_t, ConsumerOrder> runningConsumers;             // Watt (negativi) -> accesi a quella potenza
+
+    // Controllo di ammissione (opzionale): un carico si accende solo se la potenza
+    // impegnata nei minuti in cui restera' acceso lo consente, altrimenti viene
+    // rinviato al primo minuto utile. Impegni: dispositivi accesi, timer futuri,
+    // richieste rinviate (il minuto promesso resta prenotato). Se oggi non c'e'
+    // nessun minuto utile la richiesta aspetta che un carico acceso si spenga
+    struct Reservation {
+        std::uint16_t from;
+        std::uint16_t to;
+        std::int32_t watts;
+    };
+    bool admissionControl = false;
+    ReservationTable reservations;
+    std::unordered_map<DeviceHandle, Reservation> running;              // Carichi accesi
+    std::unordered_map<DeviceHandle, Reservation> scheduled;            // Timer non ancora scattati
+    std::unordered_map<DeviceHandle, Reservation> deferred;             // Richieste rinviate
+    std::multimap<int, DeviceHandle> deferredQueue;                     // Minuto promesso -> dispositivo
+    std::vector<DeviceHandle> waitingForPower;                          // Richieste senza minuto utile, in ordine di arrivo
+    bool bookingsReleased = false;                                      // Un carico acceso ha liberato il suo impegno
+
+    // Report in cache: validi finche' non cambia la versione (transizioni, dispositivi)
+    std::uint64_t stateVersion = 0;
+    mutable std::vector<std::pair<std::string, double>> energyReport;
+    mutable std::uint64_t energyReportVersion = ~std::uint64_t(0);
+    mutable int energyReportMinutes = -1;
+
+    // Batterie (StorageDevice): tra un evento e l'altro la potenza e' costante,
+    // quindi l'energia accumulata e' lineare nel tempo e si calcola in forma
+    // chiusa quando serve. Eventi: transizioni, batteria piena o scarica
+    // (il minuto e' noto in anticipo) e i tick con produttori a profilo
+    struct BatteryState {
+        double storedWh = 0.0;                                          // Energia accumulata al minuto since
+        int since = 0;
+        std::int32_t watts = 0;                                         // > 0 scarica verso la casa, < 0 carica
+        int until = std::numeric_limits<int>::max();                    // Minuto in cui si riempie o si svuota
+    };
+    std::map<DeviceHandle, BatteryState> batteries;                     // Per handle: ordine di intervento fisso
+    std::int64_t batteryWatts = 0;                                      // Somma delle potenze delle batterie
+    int nextBatteryEvent = std::numeric_limits<int>::max();
     
     // Metodi privati di utility
+    // Stime per il report della memoria: malloc aggiunge 8 byte e arrotonda a 16 (minimo 32)
+    static std::size_t mallocBytes(std::size_t bytes) {
+        return std::max<std::size_t>(32, (bytes + 8 + 15) / 16 * 16);
+    }
+
+    template <typename Tree>
+    static std::size_t treeBytes(const Tree& tree) {
+        return tree.size() * mallocBytes(32 + sizeof(typename Tree::value_type));   // Colore e tre puntatori
+    }
+
+    template <typename Table>
+    static std::size_t hashBytes(const Table& table) {
+        return table.size() * mallocBytes(sizeof(void*) + sizeof(typename Table::value_type))
+             + table.bucket_count() * sizeof(void*);
+    }
+
+    template <typename T>
+    static std::size_t vectorBytes(const std::vector<T>& vector) {
+        return vector.capacity() * sizeof(T);
+    }
+
+    // O(1): la posizione in activeDevices e' nella storia, nessuna scansione a pari priorita'
+    void eraseActive(DeviceHandle handle) {
+        activeDevices.erase(histories.find(handle)->second.active);
+    }
+
+    enum class Admission { ADMITTED, DEFERRED, REJECTED };
+
+    void hold(std::unordered_map<DeviceHandle, Reservation>& table, DeviceHandle handle,
+              int from, int to, std::int32_t watts) {
+        reservations.reserve(from, to, watts);
+        table[handle] = {static_cast<std::uint16_t>(from), static_cast<std::uint16_t>(to), watts};
+    }
+
+    // true se il dispositivo aveva un impegno in quella tabella
+    bool drop(std::unordered_map<DeviceHandle, Reservation>& table, DeviceHandle handle) {
+        auto it = table.find(handle);
+        if (it == table.end()) return false;
+        reservations.reserve(it->second.from, it->second.to, -it->second.watts);
+        table.erase(it);
+        return true;
+    }
+
+    void stopWaiting(DeviceHandle handle) {
+        auto it = std::find(waitingForPower.begin(), waitingForPower.end(), handle);
+        if (it != waitingForPower.end()) waitingForPower.erase(it);
+    }
+
+    // Una richiesta in attesa per un timer gia' spento non ha piu' nulla da accendere
+    bool timerOver(DeviceHandle handle) const {
+        if (handle >= timerOf.size() || timerOf[handle] == NO_TIMER) return false;
+        const Timer& timer = timers[timerOf[handle]];
+        return timer.stopTimeMinutes != Timer::NO_STOP && timer.stopTimeMinutes <= currentMinute;
+    }
+
+    // Fine (esclusa) dell'accensione che inizia a start: fine del ciclo per gli
+    // AutoDevice, spegnimento del timer o mezzanotte per i manuali
+    int reservationEnd(DeviceHandle handle, int start) const {
+        if (const auto* autoDevice = std::get_if<AutoDevice>(&arena[handle])) {
+            return std::min(start + autoDevice->getDuration(), MINUTES_PER_DAY);
+        }
+        if (handle < timerOf.size() && timerOf[handle] != NO_TIMER) {
+            const Timer& timer = timers[timerOf[handle]];
+            if (timer.stopTimeMinutes != Timer::NO_STOP && timer.stopTimeMinutes > start) {
+                return timer.stopTimeMinutes;
+            }
+        }
+        return MINUTES_PER_DAY;
+    }
+
+    std::int64_t gridLimitWatts() const {
+        return std::llround(MAX_POWER_FROM_GRID * 1000.0);
+    }
+
+    // Accende subito se l'impegno lo consente, altrimenti prenota il primo minuto utile;
+    // senza minuti utili la richiesta resta in attesa (vedi admitWaiting).
+    // Due ricerche nell'albero per tentativo: O(log minuti)
+    Admission admit(DeviceHandle handle) {
+        std::int32_t watts = -arena.device(handle).getPowerWatts();
+        if (watts <= 0) {
+            switchOn(handle);       // I produttori non impegnano potenza
+            return Admission::ADMITTED;
+        }
+        // I propri impegni non contano contro la richiesta: quello del timer (che
+        // stia scattando o no) diventa l'accensione o il rinvio
+        drop(deferred, handle);
+        drop(scheduled, handle);
+        stopWaiting(handle);
+
+        const std::int64_t limit = gridLimitWatts();
+        int end = reservationEnd(handle, currentMinute);
+        if (reservations.peakOver(currentMinute, end) + watts <= limit) {
+            hold(running, handle, currentMinute, end, watts);
+            switchOn(handle);
+            return Admission::ADMITTED;
+        }
+        int start = reservations.earliestStart(currentMinute + 1,
+            [this, handle](int from) { return reservationEnd(handle, from); }, watts, limit);
+        if (start < 0) {
+            scheduleTimer(handle);      // Resta spento: il suo timer torna prenotato
+            waitingForPower.push_back(handle);
+            return Admission::REJECTED;
+        }
+        hold(deferred, handle, start, reservationEnd(handle, start), watts);
+        deferredQueue.insert({start, handle});
+        return Admission::DEFERRED;
+    }
+
+    // Richieste rinviate il cui minuto e' arrivato (le voci superate vengono scartate)
+    bool admitDeferred() {
+        bool turnedOn = false;
+        while (!deferredQueue.empty() && deferredQueue.begin()->first <= currentMinute) {
+            auto [minute, handle] = *deferredQueue.begin();
+            deferredQueue.erase(deferredQueue.begin());
+            auto it = deferred.find(handle);
+            if (it == deferred.end() || it->second.from != minute) continue;
+            if (arena.device(handle).isActive()) {
+                drop(deferred, handle);
+            } else {
+                turnedOn |= admit(handle) == Admission::ADMITTED;
+            }
+        }
+        return turnedOn;
+    }
+
+    // Le richieste in attesa si ritentano, nell'ordine di arrivo, quando un carico
+    // acceso ha rilasciato il suo impegno (spegnimento, distacco, rimozione):
+    // O(richieste in attesa) solo in quel caso
+    bool admitWaiting() {
+        if (!bookingsReleased) return false;
+        bookingsReleased = false;
+        std::vector<DeviceHandle> retry;
+        retry.swap(waitingForPower);
+        bool turnedOn = false;
+        for (DeviceHandle handle : retry) {
+            if (arena.device(handle).isActive() || timerOver(handle)) continue;
+            turnedOn |= admit(handle) == Admission::ADMITTED;     // Se respinta torna in coda
+        }
+        return turnedOn;
+    }
+
+    // Prenota l'accensione futura del timer del dispositivo (se spento). Un
+    // dispositivo ha al piu' un impegno di timer: quello vecchio viene rilasciato
+    void scheduleTimer(DeviceHandle handle) {
+        drop(scheduled, handle);
+        if (!admissionControl || handle >= timerOf.size() || timerOf[handle] == NO_TIMER) return;
+        const Timer& timer = timers[timerOf[handle]];
+        std::int32_t watts = -arena.device(handle).getPowerWatts();
+        // Un timer che si spegne nel minuto in cui si accende non accende nulla
+        if (watts > 0 && timer.startTimeMinutes > currentMinute && timer.startTimeMinutes != timer.stopTimeMinutes
+            && !arena.device(handle).isActive()) {
+            hold(scheduled, handle, timer.startTimeMinutes, reservationEnd(handle, timer.startTimeMinutes), watts);
+        }
+    }
+
+    // Accensione senza controllo del limite di potenza (vedi turnOnDevice)
+    void switchOn(DeviceHandle handle) {
+        settleGrid();
+        // Per dispositivi automatici imposta anche il tempo di inizio
+        turnOn(arena[handle], currentMinute);
+        noteTransition(handle, true);
+        DeviceHistory& history = histories[handle];
+        history.onSince = currentMinute;
+        // Inserito in fondo alla sua priorita': a pari priorita' si distacca il primo acceso
+        history.active = activeDevices.emplace(arena.device(handle).getPriority(), handle);
+    }
+
+    // Spegnimento senza ribilanciare le batterie (vedi turnOffDevice); false se era gia' spento
+    bool switchOff(DeviceHandle handle) {
+        if (arena.contains(handle)) {
+            drop(deferred, handle);     // Spegnere annulla anche un'accensione rinviata o in attesa
+            stopWaiting(handle);
+        }
+        if (arena.contains(handle) && arena.device(handle).isActive()) {
+            settleGrid();
+            closeInterval(handle);
+            turnOff(arena[handle]);
+            noteTransition(handle, false);
+
+            // Rimuovi dai dispositivi attivi
+            eraseActive(handle);
+            return true;
+        }
+        return false;
+    }
+
+    // Transizione voluta per un dispositivo dal suo timer e dalla scadenza del ciclo
+    void proposeTransition(DeviceHandle handle, int minute, std::vector<Transition>& out) const {
+        const Device& device = arena.device(handle);
+        bool on = device.isActive();
+        bool next = on;
+        if (handle < timerOf.size() && timerOf[handle] != NO_TIMER) {
+            const Timer& timer = timers[timerOf[handle]];
+            if (minute == timer.startTimeMinutes) next = true;
+            // Spegnimento anche se acceso in questo stesso minuto
+            if (timer.stopTimeMinutes != Timer::NO_STOP && minute == timer.stopTimeMinutes) next = false;
+        }
+        if (on) {
+            const auto* autoDevice = std::get_if<AutoDevice>(&arena[handle]);
+            if (autoDevice && autoDevice->shouldTurnOff(minute)) next = false;
+        }
+        if (next != on) out.push_back({handle, device.getPriority(), next});
+    }
+
+    // Transizioni dello shard: la sua parte dei timer e degli AutoDevice accesi
+    // senza timer (quelli con timer li valuta il timer). Il lavoro e' proporzionale
+    // ai dispositivi che possono cambiare stato, non agli slot dell'arena.
+    // Solo letture: gli shard possono girare in parallelo
+    void proposeTransitions(unsigned shard, unsigned shards, int minute, std::vector<Transition>& out) const {
+        out.clear();
+        std::size_t from = timers.size() * shard / shards;
+        std::size_t to = timers.size() * (shard + 1) / shards;
+        for (std::size_t i = from; i < to; i++) {
+            if (timers[i].isValid) proposeTransition(timers[i].device, minute, out);
+        }
+        from = activeAutos.size() * shard / shards;
+        to = activeAutos.size() * (shard + 1) / shards;
+        for (std::size_t i = from; i < to; i++) {
+            DeviceHandle handle = activeAutos[i];
+            if (handle >= timerOf.size() || timerOf[handle] == NO_TIMER) proposeTransition(handle, minute, out);
+        }
+    }
+
+    void trackActiveAuto(DeviceHandle handle, bool on) {
+        auto it = activeAutoIndex.find(handle);
+        if (on && it == activeAutoIndex.end()) {
+            activeAutoIndex.emplace(handle, static_cast<std::uint32_t>(activeAutos.size()));
+            activeAutos.push_back(handle);
+        } else if (!on && it != activeAutoIndex.end()) {
+            // Rimozione O(1): l'ultimo prende il posto del rimosso
+            std::uint32_t position = it->second;
+            activeAutoIndex.erase(it);
+            if (position + 1 != activeAutos.size()) {
+                activeAutos[position] = activeAutos.back();
+                activeAutoIndex[activeAutos[position]] = position;
+            }
+            activeAutos.pop_back();
+        }
+    }
+
+    // Potenza istantanea: per i produttori con profilo e' letta dalla tabella
+    double currentPower(DeviceHandle handle) const {
+        auto it = profiles.find(handle);
+        return it != profiles.end() ? it->second.powerAt(currentMinute) : arena.device(handle).getPower();
+    }
+
+    // Potenza netta dei dispositivi attivi (consumi negativi): O(produttori con profilo)
+    // grazie ai totali in watt mantenuti a ogni transizione; le batterie contano
+    // come produzione quando si scaricano e come consumo quando si caricano
     double calculateTotalPower() const {
-        double total = 0.0;
-        for (const auto& [priority, device] : activeDevices) {
-            total += device->getPower();
+        return currentProductionKw() + (batteryWatts - activeLoadWatts) / 1000.0;
+    }
+
+    // Costo di un intervallo di accensione: O(1) grazie alle somme prefisse della tariffa.
+    // Solo i carichi hanno un costo proprio: quanto vale la produzione dipende da
+    // cosa consuma la casa in quel momento (vedi gridCostBetween)
+    double intervalCost(DeviceHandle handle, int from, int to) const {
+        double power = arena.device(handle).getPower();
+        return power < 0.0 && profiles.find(handle) == profiles.end() ? tariff.intervalCost(from, to, power) : 0.0;
+    }
+
+    // Costo della rete in [from, to) con i dispositivi accesi ora, batterie comprese:
+    // prelievo alla tariffa, immissione al prezzo di immissione. A potenza costante
+    // e' O(1). Con produttori a profilo accesi si procede per ore: se nell'ora il
+    // netto non cambia segno (limiti dei profili nell'ora) il costo viene dalle somme
+    // prefisse di energia e di prezzo * profilo, O(profili); solo le ore in cui il
+    // segno puo' cambiare si sommano minuto per minuto
+    double gridCostBetween(int from, int to) const {
+        if (to <= from) return 0.0;
+        double fixedKw = (activeFixedProductionWatts - activeLoadWatts + batteryWatts) / 1000.0;
+        bool followsProfile = false;
+        for (const auto& [handle, profile] : profiles) {
+            followsProfile |= arena.device(handle).isActive();
         }
-        return total;
+        if (!followsProfile) return tariff.intervalCost(from, to, fixedKw);
+
+        double cost = 0.0;
+        for (int start = from; start < to;) {
+            int block = start / ProductionProfile::BLOCK_MINUTES;
+            int end = std::min(to, (block + 1) * ProductionProfile::BLOCK_MINUTES);
+            double lowestKw = fixedKw, highestKw = fixedKw, producedKwh = 0.0, savedEur = 0.0;
+            for (const auto& [handle, profile] : profiles) {
+                if (!arena.device(handle).isActive()) continue;
+                lowestKw += profile.lowestInBlock(block % ProductionProfile::BLOCKS);
+                highestKw += profile.highestInBlock(block % ProductionProfile::BLOCKS);
+                producedKwh += profile.energyBetween(start, end);
+                savedEur += Tariff::savedBetween(profileSavings.find(handle)->second, start, end);
+            }
+            if (highestKw <= 0.0 && fixedKw <= 0.0) {
+                cost += tariff.intervalCost(start, end, fixedKw) - savedEur;                         // Solo prelievo
+            } else if (lowestKw > 0.0) {
+                cost -= tariff.getFeedInPrice() * (fixedKw * (end - start) / 60.0 + producedKwh);   // Solo immissione
+            } else {
+                for (int m = start; m < end; m++) {
+                    double netKw = fixedKw;
+                    for (const auto& [handle, profile] : profiles) {
+                        if (arena.device(handle).isActive()) netKw += profile.powerAt(m);
+                    }
+                    cost += tariff.intervalCost(m, m + 1, netKw);
+                }
+            }
+            start = end;
+        }
+        return cost;
     }
 
-    void enforceMaxPowerPolicy() {
-        double totalPower = calculateTotalPower();
-        double maxAllowedPower = MAX_POWER_FROM_GRID;
+    // Chiude l'intervallo aperto del bilancio: va chiamata prima di ogni
+    // cambiamento della potenza netta (accensioni, spegnimenti, profili)
+    void settleGrid() {
+        gridCost += gridCostBetween(gridSince, currentMinute);
+        gridSince = currentMinute;
+    }
+
+    double openCost(DeviceHandle handle, const DeviceHistory& history, int until) const {
+        return history.onSince >= 0 && until > history.onSince ? intervalCost(handle, history.onSince, until) : 0.0;
+    }
+
+    void closeInterval(DeviceHandle handle) {
+        auto it = histories.find(handle);
+        if (it != histories.end()) {
+            it->second.closedCost += openCost(handle, it->second, currentMinute);
+            it->second.onSince = -1;
+        }
+    }
+
+    double deviceCost(DeviceHandle handle, int currentTimeMinutes) const {
+        auto it = histories.find(handle);
+        return it != histories.end() ? it->second.closedCost + openCost(handle, it->second, currentTimeMinutes) : 0.0;
+    }
+
+    // Da chiamare a ogni accensione/spegnimento: aggiorna i totali e il bit nella pagina di stato
+    void noteTransition(DeviceHandle handle, bool on) {
+        if (profiles.find(handle) == profiles.end() && !std::holds_alternative<StorageDevice>(arena[handle])) {
+            std::int32_t watts = arena.device(handle).getPowerWatts();
+            std::int64_t delta = on ? std::abs(watts) : -std::abs(watts);
+            if (watts < 0) {
+                activeLoadWatts += delta;
+            } else {
+                activeFixedProductionWatts += delta;
+            }
+        }
+        if (std::holds_alternative<AutoDevice>(arena[handle])) trackActiveAuto(handle, on);
+        stateVersion++;
+        // Acceso, l'impegno e' in running; spento, torna quello del suo timer
+        if (!on) bookingsReleased |= drop(running, handle);
+        scheduleTimer(handle);
+        recordTimeline(handle, on);
+        if (statusPage) statusPage->setDeviceOn(handle, on);
+    }
+
+    int historyMinute(int minute) const { return dayStarts.back() + minute; }
+
+    // Energia dall'inizio del giorno corrente, come negli altri report
+    double energyToday(const EnergyTimeline& timeline, int minute) const {
+        return timeline.energyUntil(minute) - timeline.energyUntil(dayStarts.back());
+    }
+
+    // Energia di un profilo tra due minuti assoluti della storia: ogni giorno
+    // ripercorre il profilo dalla mezzanotte. O(log giorni + giorni attraversati)
+    double profileEnergy(const ProductionProfile& profile, int from, int to) const {
+        double energy = 0.0;
+        auto day = std::upper_bound(dayStarts.begin(), dayStarts.end(), from) - 1;
+        while (from < to) {
+            int end = day + 1 != dayStarts.end() ? std::min(to, *(day + 1)) : to;
+            energy += profile.energyBetween(from - *day, end - *day);
+            from = end;
+            ++day;
+        }
+        return energy;
+    }
+
+    // Energia di un tratto della storia di un dispositivo (vedi EnergyTimeline)
+    auto profileRate(const ProductionProfile* profile) const {
+        return [this, profile](std::int64_t level, int from, int to) {
+            return level == EnergyTimeline::FOLLOWS_PROFILE
+                ? (profile ? profileEnergy(*profile, from, to) : 0.0)
+                : EnergyTimeline::wattRate(level, from, to);
+        };
+    }
+
+    auto deviceRate(DeviceHandle handle) const {
+        auto it = profiles.find(handle);
+        return profileRate(it != profiles.end() ? &it->second : nullptr);
+    }
+
+    // La storia delle batterie la scrive balanceBatteries, che ne decide la potenza
+    void recordTimeline(DeviceHandle handle, bool on) {
+        if (batteries.find(handle) == batteries.end()) {
+            std::int64_t level = 0;
+            if (on) {
+                level = profiles.find(handle) != profiles.end()
+                    ? EnergyTimeline::FOLLOWS_PROFILE
+                    : arena.device(handle).getPowerWatts();
+            }
+            EnergyTimeline& timeline = histories[handle].timeline;
+            rankConsumer(handle, timeline, false);
+            timeline.set(historyMinute(currentMinute), level, deviceRate(handle));
+            rankConsumer(handle, timeline, true);
+        }
+        householdTimeline.set(historyMinute(currentMinute), activeFixedProductionWatts - activeLoadWatts + batteryWatts);
+    }
+
+    // Inserisce (o toglie) un dispositivo nell'ordine dei consumatori secondo la sua
+    // storia al minuto corrente: O(log n). Va chiamata prima e dopo ogni modifica
+    // della storia; batterie e produttori con profilo non vi compaiono
+    void rankConsumer(DeviceHandle handle, const EnergyTimeline& timeline, bool insert) {
+        std::int64_t level = timeline.level();
+        if (level == EnergyTimeline::FOLLOWS_PROFILE) return;
+        int now = historyMinute(currentMinute);
+        std::int64_t energy = std::llround(energyToday(timeline, now) * 60000.0);
+        if (level < 0) {
+            ConsumerOrder& group = runningConsumers[level];
+            std::pair<std::int64_t, DeviceHandle> key{energy - level * now, handle};
+            if (insert) {
+                group.insert(key);
+            } else {
+                group.erase(key);
+            }
+            if (group.empty()) runningConsumers.erase(level);
+        } else if (energy < 0) {
+            if (insert) {
+                idleConsumers.insert({energy, handle});
+            } else {
+                idleConsumers.erase({energy, handle});
+            }
+        }
+    }
+
+    // Visita i consumatori in ordine di energia assorbita nel giorno fino al minuto dato (il
+    // maggiore prima, anche quelli ora spenti) finche' visit(handle, kWh) restituisce
+    // true. Al minuto corrente fonde gli spenti con i gruppi per potenza:
+    // O((gruppi + visitati) * log gruppi). Una finestra gia' passata non e'
+    // indicizzata: si ricalcola dalla storia in O(n log n)
+    template <typename Visit>
+    void visitConsumers(int totalMinutes, Visit&& visit) const {
+        int until = historyMinute(std::min(totalMinutes, currentMinute));
+        if (until != historyMinute(currentMinute)) {
+            std::vector<std::pair<std::int64_t, DeviceHandle>> past;
+            for (const auto& [handle, history] : histories) {
+                if (batteries.find(handle) != batteries.end() || profiles.find(handle) != profiles.end()) continue;
+                std::int64_t energy = std::llround(energyToday(history.timeline, until) * 60000.0);
+                if (energy < 0) past.emplace_back(energy, handle);
+            }
+            std::sort(past.begin(), past.end());
+            for (const auto& [energy, handle] : past) {
+                if (!visit(handle, energyToday(histories.find(handle)->second.timeline, until))) return;
+            }
+            return;
+        }
+
+        struct Cursor {
+            std::int64_t energy;                // Watt-minuto al minuto until
+            ConsumerOrder::const_iterator it, end;
+            std::int64_t level;                 // 0 per gli spenti
+        };
+        auto after = [](const Cursor& a, const Cursor& b) {
+            return a.energy != b.energy ? a.energy > b.energy : a.it->second > b.it->second;
+        };
+        std::vector<Cursor> heap;
+        heap.reserve(runningConsumers.size() + 1);
+        if (!idleConsumers.empty()) {
+            heap.push_back({idleConsumers.begin()->first, idleConsumers.begin(), idleConsumers.end(), 0});
+        }
+        for (const auto& [level, group] : runningConsumers) {
+            heap.push_back({group.begin()->first + level * until, group.begin(), group.end(), level});
+        }
+        std::make_heap(heap.begin(), heap.end(), after);
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), after);
+            Cursor& cursor = heap.back();
+            if (cursor.energy >= 0) return;     // Accesi in questo minuto: non hanno ancora consumato
+            // L'energia stampata viene dalla storia, come negli altri report
+            DeviceHandle handle = cursor.it->second;
+            if (!visit(handle, energyToday(histories.find(handle)->second.timeline, until))) return;
+            if (++cursor.it == cursor.end) {
+                heap.pop_back();
+            } else {
+                cursor.energy = cursor.it->first + cursor.level * until;
+                std::push_heap(heap.begin(), heap.end(), after);
+            }
+        }
+    }
+
+    void showEnergyLine(OutputBuffer& out, DeviceHandle handle, double energy) const {
+        out << devices.name(handle) << ": ";
+        out.fixed(energy) << " kWh\n";
+    }
+
+    double currentProductionKw() const {
+        double production = activeFixedProductionWatts / 1000.0;
+        for (const auto& [handle, profile] : profiles) {
+            if (arena.device(handle).isActive()) production += profile.powerAt(currentMinute);
+        }
+        return production;
+    }
+
+    // Le batterie non sono produzione: hanno un campo a parte e contano solo nel prelievo
+    void publishStatus(double production) {
+        if (statusPage) {
+            double battery = batteryWatts / 1000.0;
+            statusPage->publish(currentMinute, std::max(0.0, activeLoadWatts / 1000.0 - production - battery),
+                                production, battery, consumedKwh, producedKwh, shedCount);
+        }
+    }
+
+    // Contabilita' di fine tick: O(numero di produttori con profilo)
+    void accountTick() {
+        double production = currentProductionKw();
+        consumedKwh += activeLoadWatts / 60000.0;
+        producedKwh += production / 60.0;
+        publishStatus(production);
+    }
+
+    double deviceEnergy(DeviceHandle handle, int totalMinutes) const {
+        if (batteries.find(handle) != batteries.end()) {
+            // Energia netta ceduta alla casa (negativa se ha assorbito piu' di quanto ha reso)
+            auto history = histories.find(handle);
+            return history != histories.end()
+                ? history->second.timeline.energyUntil(historyMinute(std::min(totalMinutes, currentMinute)))
+                : 0.0;
+        }
+        auto it = profiles.find(handle);
+        if (it != profiles.end()) {
+            return arena.device(handle).isActive()
+                ? it->second.energyBetween(0, std::min(totalMinutes, MINUTES_PER_DAY))
+                : 0.0;
+        }
+        return arena.device(handle).calculateEnergy(totalMinutes);
+    }
+
+    double maxAllowedPower() const {
+        double maxAllowed = MAX_POWER_FROM_GRID;
 
         // Aggiungi potenza dal fotovoltaico se presente e attivo
-        auto it = devices.find("fotovoltaico");
-        if (it != devices.end() && it->second->isActive()) {
-            maxAllowedPower += std::abs(it->second->getPower());
+        DeviceHandle pv = photovoltaic;
+        if (pv != INVALID_DEVICE && arena.device(pv).isActive()) {
+            maxAllowed += photovoltaicProfile
+                ? photovoltaicProfile->powerAt(currentMinute)
+                : std::abs(arena.device(pv).getPower());
         }
+        return maxAllowed;
+    }
+
+    // Energia accumulata al minuto dato, con la potenza corrente: O(1)
+    double storedAt(DeviceHandle handle, const BatteryState& state, int minute) const {
+        const auto& storage = std::get<StorageDevice>(arena[handle]);
+        double rate = state.watts > 0 ? state.watts : state.watts * storage.getEfficiency();
+        double stored = state.storedWh - rate * std::max(minute - state.since, 0) / 60.0;
+        return std::clamp(stored, 0.0, storage.getCapacityWh());
+    }
+
+    // Ridistribuisce le batterie sul bilancio corrente della casa: l'eccedenza
+    // di produzione le carica, il prelievo oltre il limite le scarica (prima
+    // del distacco dei carichi). La potenza e' limitata anche dall'energia
+    // disponibile, cosi' il minuto in cui una batteria si riempie o si svuota
+    // cade su un minuto intero ed e' un evento esatto. O(numero di batterie)
+    void balanceBatteries() {
+        if (batteries.empty()) return;
+        const double production = currentProductionKw();
+        double surplus = production * 1000.0 - activeLoadWatts;
+        double excess = activeLoadWatts - production * 1000.0 - maxAllowedPower() * 1000.0;
 
-        // Se la potenza totale supera il massimo, spegni i dispositivi in ordine
-        while (totalPower < -maxAllowedPower) {  // Nota: i consumi sono negativi
-            // Trova il dispositivo con priorità più bassa che può essere spento
-            auto it = std::find_if(activeDevices.begin(), activeDevices.end(),
-                [](const auto& pair) { return pair.second->canBeTurnedOff(); });
+        bool changed = false;
+        nextBatteryEvent = std::numeric_limits<int>::max();
+        for (auto& [handle, state] : batteries) {
+            const auto& storage = std::get<StorageDevice>(arena[handle]);
+            state.storedWh = storedAt(handle, state, currentMinute);
+            state.since = currentMinute;
 
-            if (it == activeDevices.end()) {
-                throw std::runtime_error("Impossibile rispettare il limite di potenza!");
+            std::int32_t watts = 0;
+            double room = storage.getCapacityWh() - state.storedWh;
+            if (storage.isActive() && surplus >= 1.0 && room > 0.0) {
+                double charge = std::min({static_cast<double>(storage.getChargeLimitWatts()), surplus,
+                                          room * 60.0 / storage.getEfficiency()});
+                watts = -static_cast<std::int32_t>(charge);
+                surplus += watts;
+            } else if (storage.isActive() && excess > 0.0 && state.storedWh > 0.0) {
+                double discharge = std::min({static_cast<double>(storage.getDischargeLimitWatts()),
+                                             std::ceil(excess), state.storedWh * 60.0});
+                watts = static_cast<std::int32_t>(discharge);
+                excess -= watts;
             }
 
-            it->second->turnOff();
-            totalPower -= it->second->getPower();
-            activeDevices.erase(it);
+            if (watts != state.watts) {
+                if (!changed) settleGrid();
+                batteryWatts += watts - state.watts;
+                state.watts = watts;
+                histories[handle].timeline.set(historyMinute(currentMinute), watts);
+                changed = true;
+            }
+            state.until = std::numeric_limits<int>::max();
+            if (watts > 0) {
+                state.until = currentMinute + static_cast<int>(state.storedWh * 60.0 / watts + 1e-9);
+            } else if (watts < 0) {
+                state.until = currentMinute + static_cast<int>(room * 60.0 / (-watts * storage.getEfficiency()) + 1e-9);
+            }
+            nextBatteryEvent = std::min(nextBatteryEvent, state.until);
+        }
+        if (changed) {
+            stateVersion++;
+            householdTimeline.set(historyMinute(currentMinute), activeFixedProductionWatts - activeLoadWatts + batteryWatts);
+        }
+    }
+
+    // Dopo spegnimenti e rimozioni: se le batterie ora cedono meno di prima (una
+    // spenta, da un timer o a mano) il prelievo che coprivano torna sulla rete e
+    // va riportato nel limite come dopo un'accensione
+    void rebalanceBatteries(std::int64_t wattsBefore) {
+        balanceBatteries();
+        if (batteryWatts < wattsBefore) enforceMaxPowerPolicy();
+    }
+
+    void enforceMaxPowerPolicy() {
+        balanceBatteries();
+        double totalPower = calculateTotalPower();
+
+        // Nota: i consumi sono negativi, l'eccesso e' quanto si assorbe oltre il limite
+        double excess = -totalPower - maxAllowedPower();
+        if (excess < SheddingStrategy::TOLERANCE_KW) return;
+
+        // Candidati in ordine di priorita' crescente; la strategia decide chi spegnere
+        sheddingCandidates.clear();
+        for (const auto& [priority, handle] : activeDevices) {
+            if (canBeTurnedOff(arena[handle])) {
+                sheddingCandidates.push_back({handle, priority, -currentPower(handle)});
+            }
+        }
+
+        toShed.clear();
+        bool feasible = shedding->select(sheddingCandidates, excess, toShed);
+
+        if (!toShed.empty()) settleGrid();
+        for (DeviceHandle handle : toShed) {
+            eraseActive(handle);
+            closeInterval(handle);
+            turnOff(arena[handle]);
+            noteTransition(handle, false);
+        }
+        shedCount += toShed.size();
+        if (!toShed.empty()) {
+            balanceBatteries();     // Il distacco puo' aver coperto anche la parte scaricata
+        }
+
+        if (!feasible) {
+            throw std::runtime_error("Impossibile rispettare il limite di potenza!");
         }
     }
 
 public:
-    explicit DeviceManager(double maxPower = 3.5) : MAX_POWER_FROM_GRID(maxPower) {}
+    explicit DeviceManager(double maxPower = 3.5)
+        : MAX_POWER_FROM_GRID(maxPower), shedding(new LowestPriorityFirst()) {}
 
-    // Gestione dispositivi
-    void addDevice(std::shared_ptr<Device> device) {
-        if (devices.find(device->getId()) != devices.end()) {
+    // I worker e la pagina di stato si riferiscono a questa istanza
+    DeviceManager(const DeviceManager&) = delete;
+    DeviceManager& operator=(const DeviceManager&) = delete;
+
+    // Pubblica lo stato in memoria condivisa dopo ogni tick (vedi statuspage.h).
+    // La pagina parte grande quanto l'arena e cresce con i nuovi handle
+    void attachStatusPage(const std::string& shmName, std::uint32_t initialCapacity = 0) {
+        std::uint32_t capacity = std::max<std::uint32_t>({initialCapacity, arena.slots(), 64u});
+        statusPage.reset(new StatusPublisher(shmName, capacity));
+        for (const auto& [priority, handle] : activeDevices) {
+            statusPage->setDeviceOn(handle, true);
+        }
+        publishStatus(currentProductionKw());
+    }
+
+    std::uint64_t getShedCount() const { return shedCount; }
+
+    // Strategia di distacco dei carichi per questa casa (predefinita: LowestPriorityFirst)
+    void setSheddingStrategy(std::unique_ptr<SheddingStrategy> strategy) {
+        shedding = std::move(strategy);
+    }
+
+    // Gestione dispositivi: il dispositivo viene costruito direttamente nell'arena
+    // Nome e ID vanno nella tabella dei nomi, gli altri argomenti al costruttore di T
+    template <typename T, typename... Args>
+    DeviceHandle addDevice(const std::string& name, const std::string& id, Args&&... args) {
+        DeviceHandle handle = arena.create<T>(std::forward<Args>(args)...);
+        bool interned;
+        try {
+            interned = devices.intern(id, name, handle);
+        } catch (...) {
+            arena.destroy(handle);
+            throw;
+        }
+        if (!interned) {
+            arena.destroy(handle);
             throw std::invalid_argument("Device ID already exists");
         }
-        devices[device->getId()] = device;
+        nameIndex.insert(handle);
+        if (id == "fotovoltaico") {
+            photovoltaic = handle;
+        }
+        if constexpr (std::is_same_v<T, StorageDevice>) {
+            batteries[handle].since = currentMinute;     // Parte scarica (vedi setStoredEnergy)
+        }
+        stateVersion++;
+        return handle;
+    }
+
+    // Risolve l'ID testuale nell'handle: da usare solo al bordo (parsing dei comandi)
+    DeviceHandle findHandle(const std::string& id) const {
+        return devices.resolve(id);
+    }
+
+    // Ricerca per nome al bordo dei comandi: elenco per prefisso, completamento, "forse intendevi"
+    std::vector<std::string> listDevices(const std::string& prefix, std::size_t limit = 50) const {
+        return nameIndex.withPrefix(prefix, limit);
+    }
+
+    std::string completeDevice(const std::string& prefix) const {
+        return nameIndex.complete(prefix);
+    }
+
+    std::vector<std::string> suggestDevices(const std::string& id) const {
+        return nameIndex.suggest(id);
     }
 
     void removeDevice(const std::string& id) {
-        auto it = devices.find(id);
-        if (it != devices.end()) {
-            if (it->second->isActive()) {
+        DeviceHandle handle = devices.resolve(id);
+        if (handle != INVALID_DEVICE) {
+            std::int64_t wattsBefore = batteryWatts;
+            bool wasActive = arena.device(handle).isActive();
+            if (wasActive) {
                 // Rimuovi dai dispositivi attivi se necessario
-                for (auto activeIt = activeDevices.begin(); activeIt != activeDevices.end(); ++activeIt) {
-                    if (activeIt->second->getId() == id) {
-                        activeDevices.erase(activeIt);
-                        break;
-                    }
-                }
+                settleGrid();
+                eraseActive(handle);
+                noteTransition(handle, false);
+            }
+            // L'handle verra' riutilizzato: nessun timer deve piu' riferirsi ad esso
+            removeTimer(handle);
+            if (handle == photovoltaic) {
+                photovoltaic = INVALID_DEVICE;
+                photovoltaicProfile = nullptr;
+            }
+            auto profile = profiles.find(handle);
+            auto history = histories.find(handle);
+            if (history != histories.end()) rankConsumer(handle, history->second.timeline, false);
+            if (profile != profiles.end() && history != histories.end() && history->second.timeline.size() > 0) {
+                retiredProducers.push_back({std::move(history->second.timeline), std::move(profile->second)});
+            }
+            if (profile != profiles.end()) profiles.erase(profile);
+            profileSavings.erase(handle);
+            if (history != histories.end()) histories.erase(history);
+            drop(deferred, handle);
+            stopWaiting(handle);
+            auto battery = batteries.find(handle);
+            if (battery != batteries.end()) {
+                settleGrid();
+                batteryWatts -= battery->second.watts;
+                batteries.erase(battery);
+                householdTimeline.set(historyMinute(currentMinute), activeFixedProductionWatts - activeLoadWatts + batteryWatts);
+            }
+            stateVersion++;
+            nameIndex.erase(handle);
+            devices.erase(handle);
+            arena.destroy(handle);
+            if (wasActive) rebalanceBatteries(wattsBefore);
+        }
+    }
+
+    // Imposta la tariffa usata per i costi; vale per gli intervalli chiusi da ora in poi
+    void setTariff(Tariff newTariff) {
+        settleGrid();
+        tariff = std::move(newTariff);
+        tariffLoaded = true;
+        for (const auto& [handle, profile] : profiles) {
+            profileSavings[handle] = tariff.savingSums(profile);
+        }
+    }
+
+    // Associa a un produttore il suo profilo di produzione (precalcolato)
+    void setProductionProfile(DeviceHandle handle, ProductionProfile profile) {
+        if (!arena.contains(handle)) {
+            throw std::invalid_argument("Device not found");
+        }
+        settleGrid();
+        if (arena.device(handle).isActive() && profiles.find(handle) == profiles.end()) {
+            // Da ora la sua produzione segue il profilo: togli il contributo fisso
+            std::int32_t watts = arena.device(handle).getPowerWatts();
+            if (watts < 0) {
+                activeLoadWatts += watts;
+            } else {
+                activeFixedProductionWatts -= watts;
             }
-            devices.erase(it);
+        }
+        stateVersion++;
+        auto history = histories.find(handle);
+        if (history != histories.end()) {
+            rankConsumer(handle, history->second.timeline, false);     // Con un profilo non e' un consumatore
+        }
+        const ProductionProfile* stored = &(profiles[handle] = std::move(profile));
+        profileSavings[handle] = tariff.savingSums(*stored);
+        if (handle == photovoltaic) {
+            photovoltaicProfile = stored;
+        }
+        if (arena.device(handle).isActive()) {
+            recordTimeline(handle, true);
         }
     }
 
+    void setProductionProfile(const std::string& id, ProductionProfile profile) {
+        setProductionProfile(findHandle(id), std::move(profile));
+    }
+
     // Gestione stati dei dispositivi
-    void turnOnDevice(const std::string& id, int currentTimeMinutes) {
-        auto it = devices.find(id);
-        if (it == devices.end()) {
+    // Restituisce il minuto a cui l'accensione e' stata rinviata dal controllo di
+    // ammissione, WAITING_FOR_POWER se oggi non c'e' posto (si accendera' quando un
+    // carico acceso si spegne), -1 se non e' stata rinviata
+    int turnOnDevice(DeviceHandle handle, int currentTimeMinutes) {
+        if (!arena.contains(handle)) {
             throw std::invalid_argument("Device not found");
         }
 
-        auto device = it->second;
-        if (!device->isActive()) {
-            device->turnOn();
-            
-            // Per dispositivi automatici, imposta il tempo di inizio
-            if (auto autoDevice = std::dynamic_pointer_cast<AutoDevice>(device)) {
-                autoDevice->setStartTime(currentTimeMinutes);
+        if (!arena.device(handle).isActive()) {
+            if (currentTimeMinutes < currentMinute) resetTime();
+            currentMinute = currentTimeMinutes;
+            if (!admissionControl) {
+                switchOn(handle);
+            } else {
+                admit(handle);
             }
+            enforceMaxPowerPolicy();
+        }
+        return getDeferredStart(handle);
+    }
+
+    int turnOnDevice(const std::string& id, int currentTimeMinutes) {
+        return turnOnDevice(findHandle(id), currentTimeMinutes);
+    }
 
-            activeDevices.insert({device->getPriority(), device});
+    void turnOffDevice(DeviceHandle handle) {
+        std::int64_t wattsBefore = batteryWatts;
+        if (!switchOff(handle)) return;
+        if (admissionControl && admitWaiting()) {
             enforceMaxPowerPolicy();
+        } else {
+            rebalanceBatteries(wattsBefore);
         }
     }
 
     void turnOffDevice(const std::string& id) {
-        auto it = devices.find(id);
-        if (it != devices.end() && it->second->isActive()) {
-            it->second->turnOff();
-            
-            // Rimuovi dai dispositivi attivi
-            for (auto activeIt = activeDevices.begin(); activeIt != activeDevices.end(); ++activeIt) {
-                if (activeIt->second->getId() == id) {
-                    activeDevices.erase(activeIt);
-                    break;
-                }
-            }
-        }
+        turnOffDevice(findHandle(id));
     }
 
     // Gestione timer
-    void addTimer(const std::string& deviceId, int startTime, int stopTime = -1) {
-        auto it = devices.find(deviceId);
-        if (it == devices.end()) {
+    void addTimer(DeviceHandle handle, int startTime, int stopTime = -1) {
+        if (!arena.contains(handle)) {
             throw std::invalid_argument("Device not found");
         }
 
         // Rimuovi eventuali timer esistenti per questo dispositivo
-        removeTimer(deviceId);
+        removeTimer(handle);
         
         // Aggiungi il nuovo timer
-        timers.emplace_back(deviceId, startTime, stopTime);
+        if (handle >= timerOf.size()) timerOf.resize(handle + 1, NO_TIMER);
+        timerOf[handle] = static_cast<std::uint32_t>(timers.size());
+        timers.emplace_back(handle, startTime, stopTime);
+        scheduleTimer(handle);
+    }
+
+    void addTimer(const std::string& deviceId, int startTime, int stopTime = -1) {
+        addTimer(findHandle(deviceId), startTime, stopTime);
+    }
+
+    void removeTimer(DeviceHandle handle) {
+        // Il timer viene solo invalidato (O(1)); il vettore si compatta quando
+        // i timer invalidi sono la meta', mantenendo l'ordine di inserimento
+        if (handle >= timerOf.size() || timerOf[handle] == NO_TIMER) return;
+        drop(scheduled, handle);
+        timers[timerOf[handle]].isValid = 0;
+        timerOf[handle] = NO_TIMER;
+        if (++invalidTimers * 2 > timers.size()) {
+            timers.erase(std::remove_if(timers.begin(), timers.end(),
+                [](const Timer& timer) { return !timer.isValid; }), timers.end());
+            for (std::uint32_t i = 0; i < timers.size(); i++) {
+                timerOf[timers[i].device] = i;
+            }
+            invalidTimers = 0;
+        }
     }
 
     void removeTimer(const std::string& deviceId) {
-        timers.remove_if([deviceId](const Timer& timer) {
-            return timer.deviceId == deviceId;
-        });
+        DeviceHandle handle = findHandle(deviceId);
+        if (handle != INVALID_DEVICE) {
+            removeTimer(handle);
+        }
     }
 
     // Metodi per il monitoraggio e la gestione del tempo
+    // Controllo di ammissione all'accensione (vedi admit). All'attivazione gli
+    // impegni si ricostruiscono dallo stato corrente; alla disattivazione le
+    // richieste rinviate vengono scartate
+    void setAdmissionControl(bool enabled) {
+        admissionControl = enabled;
+        reservations.clear();
+        running.clear();
+        scheduled.clear();
+        deferred.clear();
+        deferredQueue.clear();
+        waitingForPower.clear();
+        bookingsReleased = false;
+        if (!enabled) return;
+        for (const auto& [priority, handle] : activeDevices) {
+            std::int32_t watts = -arena.device(handle).getPowerWatts();
+            if (watts > 0) hold(running, handle, currentMinute, reservationEnd(handle, currentMinute), watts);
+        }
+        for (const Timer& timer : timers) {
+            if (timer.isValid) scheduleTimer(timer.device);
+        }
+    }
+
+    // Energia accumulata in una batteria (kWh) al minuto corrente: O(1)
+    double getStoredEnergy(DeviceHandle handle) const {
+        auto it = batteries.find(handle);
+        return arena.contains(handle) && it != batteries.end()
+            ? storedAt(handle, it->second, currentMinute) / 1000.0
+            : 0.0;
+    }
+
+    double getStoredEnergy(const std::string& id) const {
+        return getStoredEnergy(devices.resolve(id));
+    }
+
+    // Imposta lo stato di carica di una batteria (kWh, limitato alla capacita')
+    void setStoredEnergy(DeviceHandle handle, double kWh) {
+        auto it = batteries.find(handle);
+        if (!arena.contains(handle) || it == batteries.end()) {
+            throw std::invalid_argument("Device is not a storage device");
+        }
+        it->second.storedWh = std::clamp(kWh * 1000.0, 0.0, std::get<StorageDevice>(arena[handle]).getCapacityWh());
+        it->second.since = currentMinute;
+        balanceBatteries();
+    }
+
+    void setStoredEnergy(const std::string& id, double kWh) {
+        setStoredEnergy(findHandle(id), kWh);
+    }
+
+    static constexpr int WAITING_FOR_POWER = -2;
+
+    // Minuto a cui e' stata rinviata l'accensione, WAITING_FOR_POWER se aspetta
+    // che si liberi potenza, -1 se non in attesa
+    int getDeferredStart(DeviceHandle handle) const {
+        auto it = deferred.find(handle);
+        if (it != deferred.end()) return it->second.from;
+        return std::find(waitingForPower.begin(), waitingForPower.end(), handle) != waitingForPower.end()
+            ? WAITING_FOR_POWER : -1;
+    }
+
+    // Numero di thread per la valutazione dei tick (1: tutto sul thread chiamante).
+    // Il risultato non dipende dal numero di thread
+    void setTickThreads(unsigned threads) {
+        if (threads < 1) threads = 1;
+        workers.reset(threads > 1 ? new ShardWorkers(threads) : nullptr);
+        proposals.assign(threads, {});
+        // Creata una volta sola: ShardWorkers::run la riceve per riferimento a ogni tick
+        evaluateShard = [this](unsigned shard) {
+            proposeTransitions(shard, static_cast<unsigned>(proposals.size()), currentMinute, proposals[shard]);
+        };
+    }
+
+    // Reset dell'orario: il tempo riparte da 00:00 di un nuovo giorno, senza pause
+    // rispetto al minuto corrente. I costi, dei dispositivi e della casa, sono del
+    // giorno come le energie: ripartono da 0 (O(dispositivi con storia)). La storia
+    // delle accensioni continua in minuti assoluti, cosi' le energie del nuovo
+    // giorno non si mescolano con quelle del precedente; le batterie conservano la
+    // carica. I dispositivi accesi restano accesi e i cicli in corso proseguono
+    void resetTime() {
+        for (auto& [handle, state] : batteries) {
+            state.storedWh = storedAt(handle, state, currentMinute);
+            state.since = 0;
+        }
+        for (auto& [handle, history] : histories) {
+            history.closedCost = 0.0;
+        }
+        for (const auto& [priority, handle] : activeDevices) {
+            histories[handle].onSince = 0;
+            if (auto* autoDevice = std::get_if<AutoDevice>(&arena[handle])) autoDevice->shiftStartTime(currentMinute);
+        }
+        dayStarts.push_back(historyMinute(currentMinute));
+        currentMinute = 0;
+        gridCost = 0.0;
+        gridSince = 0;
+        stateVersion++;
+        // L'ordine dei consumatori conta l'energia del giorno: si riparte da zero
+        idleConsumers.clear();
+        runningConsumers.clear();
+        for (const auto& [handle, history] : histories) {
+            if (batteries.find(handle) == batteries.end() && profiles.find(handle) == profiles.end()) {
+                rankConsumer(handle, history.timeline, true);
+            }
+        }
+
+        // Gli impegni sono per minuto del giorno: si ricostruiscono, e le richieste
+        // rinviate o in attesa vengono riproposte nel nuovo giorno
+        std::vector<DeviceHandle> waiting(waitingForPower);
+        for (const auto& [handle, reservation] : deferred) waiting.push_back(handle);
+        std::sort(waiting.begin(), waiting.end());
+        setAdmissionControl(admissionControl);
+        for (DeviceHandle handle : waiting) {
+            if (!arena.device(handle).isActive()) admit(handle);
+        }
+        balanceBatteries();
+    }
+
+    // Un tick: gli shard (parti dei timer e dei cicli in corso) propongono le
+    // transizioni dei timer e delle scadenze dei cicli; le proposte si applicano spegnimenti
+    // prima, poi accensioni per priorita' decrescente (a pari priorita' per
+    // handle), con un solo controllo del limite di potenza alla fine
     void checkAndUpdateDevices(int currentTimeMinutes) {
-        // Controlla i timer
-        for (auto& timer : timers) {
-            if (!timer.isValid) continue;
-
-            auto device = devices[timer.deviceId];
-            
-            // Gestisci accensione
-            if (currentTimeMinutes == timer.startTimeMinutes && !device->isActive()) {
-                turnOnDevice(timer.deviceId, currentTimeMinutes);
-            }
-            
-            // Gestisci spegnimento per dispositivi manuali
-            if (timer.stopTimeMinutes != -1 && 
-                currentTimeMinutes == timer.stopTimeMinutes && 
-                device->isActive()) {
-                turnOffDevice(timer.deviceId);
-            }
-        }
-
-        // Controlla i dispositivi automatici per lo spegnimento
-        for (auto it = activeDevices.begin(); it != activeDevices.end();) {
-            if (auto autoDevice = std::dynamic_pointer_cast<AutoDevice>(it->second)) {
-                if (autoDevice->shouldTurnOff(currentTimeMinutes)) {
-                    turnOffDevice(autoDevice->getId());
-                    it = activeDevices.begin(); // Reset iterator after modification
-                } else {
-                    ++it;
-                }
-            } else {
-                ++it;
+        if (currentTimeMinutes < currentMinute) resetTime();    // Orario tornato indietro senza reset
+        // Una batteria si riempie o si svuota
+        bool batteryEvent = !batteries.empty() && currentTimeMinutes >= nextBatteryEvent;
+        std::int64_t wattsBefore = batteryWatts;
+        currentMinute = currentTimeMinutes;
+
+        if (workers) {
+            workers->run(evaluateShard);
+        } else {
+            proposeTransitions(0, 1, currentMinute, proposals[0]);
+        }
+
+        transitions.clear();
+        for (const auto& shard : proposals) {
+            transitions.insert(transitions.end(), shard.begin(), shard.end());
+        }
+        std::sort(transitions.begin(), transitions.end(), [](const Transition& a, const Transition& b) {
+            if (a.on != b.on) return !a.on;
+            if (a.priority != b.priority) return a.priority > b.priority;
+            return a.device < b.device;
+        });
+
+        // Gli spegnimenti vengono prima nell'ordine: liberano potenza per le
+        // richieste rinviate, che hanno la precedenza sulle nuove accensioni
+        auto firstOn = std::find_if(transitions.begin(), transitions.end(),
+            [](const Transition& transition) { return transition.on; });
+        for (auto it = transitions.begin(); it != firstOn; ++it) {
+            switchOff(it->device);
+        }
+        bool turnedOn = false;
+        if (admissionControl) {
+            turnedOn = admitDeferred();
+            turnedOn |= admitWaiting();
+        }
+        for (auto it = firstOn; it != transitions.end(); ++it) {
+            if (arena.device(it->device).isActive()) continue;     // Richiesta rinviata a questo stesso minuto
+            if (!admissionControl) {
+                switchOn(it->device);
+                turnedOn = true;
+            } else if (admit(it->device) == Admission::ADMITTED) {
+                turnedOn = true;
             }
         }
+        // Le batterie si ribilanciano solo quando il bilancio cambia: a ogni
+        // transizione, ai loro eventi e a ogni tick se c'e' produzione a profilo;
+        // il limite si ricontrolla anche se una batteria spenta cede meno di prima
+        if (turnedOn || batteryEvent) {
+            enforceMaxPowerPolicy();
+        } else if (!transitions.empty() || !profiles.empty()) {
+            rebalanceBatteries(wattsBefore);
+        }
+
+        accountTick();
     }
 
     // Metodi per il reporting
+    double getDeviceEnergy(DeviceHandle handle, int totalMinutes) const {
+        return arena.contains(handle) ? deviceEnergy(handle, totalMinutes) : 0.0;
+    }
+
     double getDeviceEnergy(const std::string& id, int totalMinutes) const {
-        auto it = devices.find(id);
-        if (it != devices.end()) {
-            return it->second->calculateEnergy(totalMinutes);
+        return getDeviceEnergy(devices.resolve(id), totalMinutes);
+    }
+
+    // Report in ordine di ID, ricostruito solo dopo una transizione o un cambio di minuto
+    const std::vector<std::pair<std::string, double>>& getAllDevicesEnergy(int totalMinutes) const {
+        if (energyReportVersion != stateVersion || energyReportMinutes != totalMinutes) {
+            const auto& order = nameIndex.ordered();
+            energyReport.resize(order.size());
+            for (std::size_t i = 0; i < order.size(); i++) {
+                energyReport[i].first.assign(devices.name(order[i]));
+                energyReport[i].second = deviceEnergy(order[i], totalMinutes);
+            }
+            energyReportVersion = stateVersion;
+            energyReportMinutes = totalMinutes;
         }
-        return 0.0;
+        return energyReport;
     }
 
-    std::vector<std::pair<std::string, double>> getAllDevicesEnergy(int totalMinutes) const {
-        std::vector<std::pair<std::string, double>> result;
-        for (const auto& [id, device] : devices) {
-            result.emplace_back(id, device->calculateEnergy(totalMinutes));
+    // Energia in [from, to) del giorno corrente dalla storia delle accensioni:
+    // O(log transizioni). I minuti oltre quello corrente non sono ancora noti e
+    // vengono ignorati
+    double getDeviceEnergyBetween(DeviceHandle handle, int from, int to) const {
+        auto it = histories.find(handle);
+        if (!arena.contains(handle) || it == histories.end()) return 0.0;
+        return it->second.timeline.energyBetween(historyMinute(from), historyMinute(std::min(to, currentMinute)),
+                                                 deviceRate(handle));
+    }
+
+    double getDeviceEnergyBetween(const std::string& id, int from, int to) const {
+        return getDeviceEnergyBetween(devices.resolve(id), from, to);
+    }
+
+    // Energia netta della casa: il totale dei dispositivi a potenza fissa piu'
+    // i (pochi) produttori con profilo, compresi quelli gia' rimossi
+    double getHouseholdEnergyBetween(int from, int to) const {
+        from = historyMinute(from);
+        to = historyMinute(std::min(to, currentMinute));
+        double energy = householdTimeline.energyBetween(from, to);
+        for (const auto& [handle, profile] : profiles) {
+            auto it = histories.find(handle);
+            if (it != histories.end()) energy += it->second.timeline.energyBetween(from, to, deviceRate(handle));
+        }
+        for (const auto& retired : retiredProducers) {
+            energy += retired.timeline.energyBetween(from, to, profileRate(&retired.profile));
+        }
+        return energy;
+    }
+
+    // Comando "show <dispositivo> HH:MM HH:MM" (INVALID_DEVICE: tutta la casa)
+    void showEnergyBetween(OutputBuffer& out, DeviceHandle handle, int from, int to) const {
+        double energy;
+        if (handle == INVALID_DEVICE) {
+            out << "Totale";
+            energy = getHouseholdEnergyBetween(from, to);
+        } else {
+            out << devices.name(handle);
+            energy = getDeviceEnergyBetween(handle, from, to);
         }
+        out << " (";
+        out.time(from) << '-';
+        out.time(to) << "): ";
+        out.fixed(energy) << " kWh\n";
+    }
+
+    // I count maggiori consumatori: O((gruppi di potenza + count) log gruppi), vedi visitConsumers
+    void showTopConsumers(OutputBuffer& out, std::size_t count, int totalMinutes) const {
+        if (count == 0) return;
+        visitConsumers(totalMinutes, [&](DeviceHandle handle, double energy) {
+            showEnergyLine(out, handle, energy);
+            return --count > 0;
+        });
+    }
+
+    // Consumatori che hanno assorbito piu' di kWh: come sopra con count = risultati + 1
+    void showConsumersOver(OutputBuffer& out, double kWh, int totalMinutes) const {
+        visitConsumers(totalMinutes, [&](DeviceHandle handle, double energy) {
+            if (-energy <= kWh) return false;
+            showEnergyLine(out, handle, energy);
+            return true;
+        });
+    }
+
+    // Costi (EUR) fino al minuto indicato: O(1) per dispositivo, qualunque sia la durata
+    double getDeviceCost(DeviceHandle handle, int currentTimeMinutes) const {
+        return arena.contains(handle) ? deviceCost(handle, currentTimeMinutes) : 0.0;
+    }
+
+    double getDeviceCost(const std::string& id, int currentTimeMinutes) const {
+        return getDeviceCost(devices.resolve(id), currentTimeMinutes);
+    }
+
+    std::vector<std::pair<std::string, double>> getAllDevicesCost(int currentTimeMinutes) const {
+        std::vector<std::pair<std::string, double>> result;
+        result.reserve(devices.size());
+        devices.forEach([&](std::string_view id, DeviceHandle handle) {
+            result.emplace_back(std::string(id), deviceCost(handle, currentTimeMinutes));
+        });
+        std::sort(result.begin(), result.end());
         return result;
     }
 
+    // Costo della casa dal bilancio netto con la rete: l'autoconsumo vale quanto
+    // l'acquisto evitato e solo l'eccedenza e' pagata al prezzo di immissione
+    double getHouseholdCost(int currentTimeMinutes) const {
+        return gridCost + gridCostBetween(gridSince, currentTimeMinutes);
+    }
+
+    // Report dei consumi scritto direttamente nel buffer di uscita, senza
+    // allocazioni per riga (usato dal comando "show")
+    void showConsumption(OutputBuffer& out, int totalMinutes) const {
+        double total = 0.0;
+        for (DeviceHandle handle : nameIndex.ordered()) {
+            double energy = deviceEnergy(handle, totalMinutes);
+            out << devices.name(handle) << ": ";
+            out.fixed(energy) << " kWh";
+            if (batteries.find(handle) != batteries.end()) {
+                out << " (accumulati ";
+                out.fixed(getStoredEnergy(handle)) << " kWh)";
+            }
+            if (tariffLoaded) {
+                double cost = deviceCost(handle, totalMinutes);
+                out << ", ";
+                out.fixed(cost, 2) << " EUR";
+            }
+            out << '\n';
+            total += energy;
+        }
+        out << "Totale: ";
+        out.fixed(total) << " kWh";
+        if (tariffLoaded) {
+            // Non e' la somma delle righe: la produzione autoconsumata riduce il prelievo
+            out << ", ";
+            out.fixed(getHouseholdCost(totalMinutes), 2) << " EUR";
+        }
+        out << '\n';
+    }
+
+    bool isDeviceActive(DeviceHandle handle) const {
+        return arena.contains(handle) && arena.device(handle).isActive();
+    }
+
     bool isDeviceActive(const std::string& id) const {
-        auto it = devices.find(id);
-        return it != devices.end() && it->second->isActive();
+        return isDeviceActive(devices.resolve(id));
+    }
+
+    std::string_view getDeviceId(DeviceHandle handle) const {
+        return devices.name(handle);
+    }
+
+    std::string_view getDeviceName(DeviceHandle handle) const {
+        return devices.displayName(handle);
+    }
+
+    MemoryReport getMemoryReport() const {
+        MemoryReport report;
+        report.devices = arena.size();
+        report.timers = timers.size() - invalidTimers;
+        report.deviceBytes = arena.bytesUsed() + devices.bytesUsed() + nameIndex.bytesUsed();
+        report.timerBytes = vectorBytes(timers) + vectorBytes(timerOf);
+        report.activeBytes = treeBytes(activeDevices) + vectorBytes(activeAutos) + hashBytes(activeAutoIndex);
+        report.historyBytes = hashBytes(histories) + householdTimeline.bytesUsed()
+                            + vectorBytes(dayStarts) + vectorBytes(retiredProducers)
+                            + treeBytes(idleConsumers) + treeBytes(runningConsumers);
+        for (const auto& [level, group] : runningConsumers) {
+            report.historyBytes += treeBytes(group);
+        }
+        for (const auto& retired : retiredProducers) {
+            report.historyBytes += retired.timeline.bytesUsed();
+        }
+        for (const auto& [handle, history] : histories) {
+            report.historyBytes += history.timeline.bytesUsed();
+        }
+        report.admissionBytes = sizeof(reservations) + hashBytes(running) + hashBytes(scheduled)
+                              + hashBytes(deferred) + treeBytes(deferredQueue) + vectorBytes(waitingForPower);
+        report.otherBytes = hashBytes(profiles) + hashBytes(profileSavings) + treeBytes(batteries)
+                          + vectorBytes(sheddingCandidates) + vectorBytes(toShed) + vectorBytes(transitions)
+                          + vectorBytes(energyReport);
+        for (const auto& shard : proposals) {
+            report.otherBytes += vectorBytes(shard);
+        }
+        const std::size_t inlineCapacity = std::string().capacity();     // ID corti: nessuna allocazione
+        for (const auto& [id, energy] : energyReport) {
+            if (id.capacity() > inlineCapacity) report.otherBytes += mallocBytes(id.capacity() + 1);
+        }
+        return report;
+    }
+
+    // Report della memoria (comando "mem"): byte totali e per elemento
+    void showMemory(OutputBuffer& out) const {
+        MemoryReport report = getMemoryReport();
+        out << "Dispositivi: " << static_cast<long long>(report.devices) << ", "
+            << static_cast<long long>(report.deviceBytes) << " byte";
+        if (report.devices > 0) {
+            out << " (";
+            out.fixed(static_cast<double>(report.deviceBytes) / report.devices, 1) << " byte/dispositivo)";
+        }
+        out << "\nTimer: " << static_cast<long long>(report.timers) << ", "
+            << static_cast<long long>(report.timerBytes) << " byte";
+        if (report.timers > 0) {
+            out << " (";
+            out.fixed(static_cast<double>(report.timerBytes) / report.timers, 1) << " byte/timer)";
+        }
+        out << "\nDispositivi accesi: " << static_cast<long long>(report.activeBytes) << " byte"
+            << "\nStoria delle accensioni: " << static_cast<long long>(report.historyBytes) << " byte"
+            << "\nControllo di ammissione: " << static_cast<long long>(report.admissionBytes) << " byte"
+            << "\nAltro (profili, batterie, buffer, report): " << static_cast<long long>(report.otherBytes) << " byte"
+            << "\nTotale: " << static_cast<long long>(report.totalBytes()) << " byte\n";
     }
 };
 
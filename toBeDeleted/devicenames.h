@@ -0,0 +1,161 @@
+#ifndef DEVICE_NAMES_H
+#define DEVICE_NAMES_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <functional>
+#include "devicearena.h"
+
+// Tabella di interning degli ID dei dispositivi: la stringa viene risolta una
+// sola volta (al bordo, quando arriva il comando) e da li' in poi si lavora
+// solo con l'handle intero.
+// Tutti i testi (ID e nome visualizzato) stanno in un unico buffer di caratteri;
+// l'indice e' una tabella hash a indirizzamento aperto di handle a 32 bit.
+// Lo spazio dei testi dei dispositivi rimossi si recupera compattando il
+// buffer quando e' per meta' inutilizzato (costo ammortizzato O(1) per rimozione).
+class DeviceNames {
+private:
+    struct Entry {
+        std::uint32_t offset = 0;     // Inizio dell'ID nel buffer dei testi
+        std::uint16_t idLength = 0;   // L'ID e' seguito subito dal nome visualizzato
+        std::uint16_t nameLength = 0;
+    };
+
+    std::vector<char> text;           // ID e nomi di tutti i dispositivi, concatenati
+                                      // (non std::string: reserve raddoppierebbe comunque)
+    std::vector<Entry> entries;       // Handle -> posizione dei testi (idLength 0: libero)
+    std::vector<DeviceHandle> slots;  // Tabella hash: INVALID_DEVICE = vuoto, TOMBSTONE = rimosso
+    std::size_t count = 0;
+    std::size_t used = 0;             // Slot non vuoti (inclusi i rimossi)
+    std::size_t deadText = 0;         // Caratteri di dispositivi rimossi ancora nel buffer
+
+    static constexpr DeviceHandle TOMBSTONE = INVALID_DEVICE - 1;
+
+    std::string_view idOf(DeviceHandle handle) const {
+        return std::string_view(text.data() + entries[handle].offset, entries[handle].idLength);
+    }
+
+    std::size_t slotFor(std::string_view id) const {
+        return std::hash<std::string_view>()(id) & (slots.size() - 1);
+    }
+
+    void rehash(std::size_t capacity) {
+        std::vector<DeviceHandle> old(capacity, INVALID_DEVICE);
+        old.swap(slots);
+        used = count;
+        for (DeviceHandle handle : old) {
+            if (handle == INVALID_DEVICE || handle == TOMBSTONE) continue;
+            std::size_t i = slotFor(idOf(handle));
+            while (slots[i] != INVALID_DEVICE) i = (i + 1) & (slots.size() - 1);
+            slots[i] = handle;
+        }
+    }
+
+    // Ricopia i testi ancora in uso in ordine di handle e aggiorna gli offset
+    void compactText() {
+        std::vector<char> compacted;
+        compacted.reserve(text.size() - deadText);
+        for (Entry& entry : entries) {
+            if (entry.idLength == 0) continue;
+            std::uint32_t offset = static_cast<std::uint32_t>(compacted.size());
+            const char* from = text.data() + entry.offset;
+            compacted.insert(compacted.end(), from, from + entry.idLength + entry.nameLength);
+            entry.offset = offset;
+        }
+        text.swap(compacted);
+        deadText = 0;
+    }
+
+    // Posizione dell'ID nella tabella, o dello slot vuoto dove andrebbe
+    std::size_t probe(std::string_view id) const {
+        std::size_t i = slotFor(id);
+        while (slots[i] != INVALID_DEVICE) {
+            if (slots[i] != TOMBSTONE && idOf(slots[i]) == id) return i;
+            i = (i + 1) & (slots.size() - 1);
+        }
+        return i;
+    }
+
+public:
+    DeviceNames() : slots(16, INVALID_DEVICE) {}
+
+    // Registra ID e nome per l'handle dato; false se l'ID e' gia' in uso
+    bool intern(std::string_view id, std::string_view name, DeviceHandle handle) {
+        if (id.empty() || resolve(id) != INVALID_DEVICE) return false;
+        // Lunghezze a 16 bit e offset a 32 bit: i valori fuori scala non vanno troncati
+        if (id.size() > 0xFFFF || name.size() > 0xFFFF) {
+            throw std::invalid_argument("Device ID or name too long");
+        }
+        if (text.size() - deadText + id.size() + name.size() > 0xFFFFFFFFu) {
+            throw std::length_error("Device name table full");
+        }
+        if (text.size() + id.size() + name.size() > 0xFFFFFFFFu) compactText();
+        if ((used + 1) * 4 > slots.size() * 3) {
+            rehash(count * 2 >= slots.size() / 2 ? slots.size() * 2 : slots.size());
+        }
+
+        // Crescita del 12,5% invece del raddoppio: con milioni di dispositivi la
+        // capacita' inutilizzata pesa piu' delle (poche) copie in piu'
+        if (handle >= entries.capacity()) entries.reserve(handle + 1 + entries.size() / 8);
+        if (handle >= entries.size()) entries.resize(handle + 1);
+        if (text.size() + id.size() + name.size() > text.capacity()) {
+            text.reserve(text.size() + id.size() + name.size() + text.size() / 8);
+        }
+        entries[handle] = {static_cast<std::uint32_t>(text.size()),
+                           static_cast<std::uint16_t>(id.size()),
+                           static_cast<std::uint16_t>(name.size())};
+        text.insert(text.end(), id.begin(), id.end());
+        text.insert(text.end(), name.begin(), name.end());
+
+        std::size_t i = probe(id);
+        slots[i] = handle;
+        count++;
+        used++;
+        return true;
+    }
+
+    void erase(DeviceHandle handle) {
+        if (handle >= entries.size() || entries[handle].idLength == 0) return;
+        std::size_t i = probe(idOf(handle));
+        if (slots[i] == handle) {
+            slots[i] = TOMBSTONE;
+            count--;
+        }
+        deadText += entries[handle].idLength + entries[handle].nameLength;
+        entries[handle] = Entry();
+        if (deadText > 4096 && deadText * 2 > text.size()) compactText();
+    }
+
+    DeviceHandle resolve(std::string_view id) const {
+        DeviceHandle handle = slots[probe(id)];
+        return handle == TOMBSTONE ? INVALID_DEVICE : handle;
+    }
+
+    std::string_view name(DeviceHandle handle) const {
+        return idOf(handle);
+    }
+
+    std::string_view displayName(DeviceHandle handle) const {
+        const Entry& entry = entries[handle];
+        return std::string_view(text.data() + entry.offset + entry.idLength, entry.nameLength);
+    }
+
+    std::size_t size() const { return count; }
+
+    // f(ID, handle) per ogni dispositivo registrato, in ordine di handle
+    template <typename F>
+    void forEach(F&& f) const {
+        for (DeviceHandle handle = 0; handle < entries.size(); handle++) {
+            if (entries[handle].idLength != 0) f(idOf(handle), handle);
+        }
+    }
+
+    std::size_t bytesUsed() const {
+        return text.capacity() + entries.capacity() * sizeof(Entry) + slots.capacity() * sizeof(DeviceHandle);
+    }
+};
+
+#endif // DEVICE_NAMES_H
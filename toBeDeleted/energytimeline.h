@@ -0,0 +1,90 @@
+#ifndef ENERGY_TIMELINE_H
+#define ENERGY_TIMELINE_H
+
+#include <limits>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// Storia di una potenza costante a tratti (un dispositivo o il totale della casa):
+// un punto per ogni cambio di livello, con l'energia accumulata fino a quel
+// minuto. L'energia in una finestra qualsiasi e' una differenza di due somme
+// prefisse, ciascuna trovata con una ricerca binaria: O(log punti). La memoria
+// cresce con il numero di transizioni, non con i minuti simulati.
+//
+// Il livello e' in watt (energia = watt * minuti / 60000), oppure FOLLOWS_PROFILE
+// per i produttori con profilo: in quel caso l'energia di un tratto la calcola
+// la funzione rate passata dal chiamante, rate(livello, da, a) -> kWh.
+class EnergyTimeline {
+public:
+    static constexpr std::int64_t FOLLOWS_PROFILE = std::numeric_limits<std::int64_t>::min();
+
+    static double wattRate(std::int64_t level, int from, int to) {
+        return level * (to - from) / 60000.0;
+    }
+
+private:
+    struct Point {
+        int minute;             // Da questo minuto vale level
+        std::int64_t level;
+        double energyBefore;    // Energia (kWh) in [0, minute)
+    };
+
+    std::vector<Point> points;
+
+public:
+    // Nuovo livello da minute in poi. I minuti devono essere non decrescenti:
+    // un minuto precedente all'ultimo punto viene portato all'ultimo punto
+    template <typename Rate>
+    void set(int minute, std::int64_t level, Rate&& rate) {
+        if (points.empty()) {
+            if (level != 0) points.push_back({minute, level, 0.0});
+            return;
+        }
+        Point& last = points.back();
+        minute = std::max(minute, last.minute);
+        if (last.minute == minute) {
+            // Piu' transizioni nello stesso minuto: conta solo l'ultima
+            last.level = level;
+            if (points.size() > 1 && points[points.size() - 2].level == level) points.pop_back();
+            return;
+        }
+        if (last.level == level) return;
+        points.push_back({minute, level, last.energyBefore + rate(last.level, last.minute, minute)});
+    }
+
+    void set(int minute, std::int64_t level) {
+        set(minute, level, wattRate);
+    }
+
+    // Energia in [0, minute): il tratto in corso si considera esteso fino a minute
+    template <typename Rate>
+    double energyUntil(int minute, Rate&& rate) const {
+        auto it = std::upper_bound(points.begin(), points.end(), minute,
+            [](int m, const Point& point) { return m < point.minute; });
+        if (it == points.begin()) return 0.0;
+        --it;
+        return it->energyBefore + rate(it->level, it->minute, minute);
+    }
+
+    double energyUntil(int minute) const {
+        return energyUntil(minute, wattRate);
+    }
+
+    template <typename Rate>
+    double energyBetween(int from, int to, Rate&& rate) const {
+        return to > from ? energyUntil(to, rate) - energyUntil(from, rate) : 0.0;
+    }
+
+    double energyBetween(int from, int to) const {
+        return energyBetween(from, to, wattRate);
+    }
+
+    // Livello in vigore dall'ultimo punto (0 se la storia e' vuota)
+    std::int64_t level() const { return points.empty() ? 0 : points.back().level; }
+
+    std::size_t size() const { return points.size(); }
+    std::size_t bytesUsed() const { return points.capacity() * sizeof(Point); }
+};
+
+#endif // ENERGY_TIMELINE_H
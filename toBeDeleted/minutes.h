@@ -0,0 +1,24 @@
+#ifndef MINUTES_H
+#define MINUTES_H
+
+#include <charconv>
+
+constexpr int MINUTES_PER_DAY = 24 * 60;
+
+// Legge un orario HH:MM all'inizio di [first, last) senza allocare; restituisce
+// i minuti dalla mezzanotte (o -1 se non valido) e in *next la posizione successiva.
+// Con allowEndOfDay e' accettato anche "24:00", utile come estremo di un intervallo.
+inline int parseClock(const char* first, const char* last, const char** next, bool allowEndOfDay = false) {
+    int hours = -1, minutes = -1;
+    auto [afterHours, errHours] = std::from_chars(first, last, hours);
+    if (errHours != std::errc() || afterHours == last || *afterHours != ':') return -1;
+
+    auto [afterMinutes, errMinutes] = std::from_chars(afterHours + 1, last, minutes);
+    if (errMinutes != std::errc() || minutes < 0 || minutes > 59 || hours < 0) return -1;
+    if (hours > 23 && !(allowEndOfDay && hours == 24 && minutes == 0)) return -1;
+
+    *next = afterMinutes;
+    return hours * 60 + minutes;
+}
+
+#endif // MINUTES_H
@@ -0,0 +1,219 @@
+#ifndef NAME_INDEX_H
+#define NAME_INDEX_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+#include "devicenames.h"
+
+// Indice alfabetico degli ID dei dispositivi per l'elenco per prefisso, il
+// completamento e i suggerimenti "forse intendevi". Non copia i testi: e' un
+// vettore di handle ordinato per ID, letti dalla tabella dei nomi (4 byte per
+// dispositivo). Un prefisso corrisponde a un intervallo contiguo del vettore,
+// come un sottoalbero di un trie, e la ricerca approssimata lo percorre come un
+// trie. Gli inserimenti si accodano e vengono ordinati e fusi alla prima
+// ricerca. Una rimozione lascia al suo posto un segnaposto con la copia dell'ID
+// (l'handle puo' essere riusato subito), cosi' l'ordine resta valido; i
+// segnaposto si tolgono tutti insieme quando sono un ottavo delle voci.
+class NameIndex {
+private:
+    // Bit alto di una voce: segnaposto, il resto e' l'indice in removedIds
+    static constexpr DeviceHandle REMOVED = 0x80000000u;
+    static constexpr std::size_t MAX_SCAN = 64;   // Oltre, una rimozione fonde prima gli inserimenti
+
+    const DeviceNames& names;
+    mutable std::vector<DeviceHandle> sorted;     // Voci in ordine di ID
+    mutable std::vector<DeviceHandle> pending;    // Inserimenti non ancora fusi in sorted
+    mutable std::vector<std::string> removedIds;  // ID dei segnaposto in sorted
+
+    std::string_view idOf(DeviceHandle entry) const {
+        return (entry & REMOVED) ? std::string_view(removedIds[entry & ~REMOVED]) : names.name(entry);
+    }
+
+    bool startsWith(DeviceHandle entry, std::string_view prefix) const {
+        return idOf(entry).substr(0, prefix.size()) == prefix;
+    }
+
+    static std::size_t commonPrefix(std::string_view a, std::string_view b) {
+        std::size_t length = 0;
+        while (length < a.size() && length < b.size() && a[length] == b[length]) length++;
+        return length;
+    }
+
+    void merge() const {
+        if (pending.empty()) return;
+        auto byId = [this](DeviceHandle a, DeviceHandle b) { return idOf(a) < idOf(b); };
+        std::sort(pending.begin(), pending.end(), byId);
+        if (sorted.empty()) {
+            sorted.swap(pending);
+        } else {
+            std::size_t middle = sorted.size();
+            if (middle + pending.size() > sorted.capacity()) sorted.reserve(middle + pending.size() + middle / 8);
+            sorted.insert(sorted.end(), pending.begin(), pending.end());
+            std::inplace_merge(sorted.begin(), sorted.begin() + middle, sorted.end(), byId);
+        }
+        std::vector<DeviceHandle>().swap(pending);
+    }
+
+    // Toglie i segnaposto: O(n), ammortizzato su almeno n/8 rimozioni
+    void purge() const {
+        if (removedIds.empty()) return;
+        sorted.erase(std::remove_if(sorted.begin(), sorted.end(),
+            [](DeviceHandle entry) { return (entry & REMOVED) != 0; }), sorted.end());
+        std::vector<std::string>().swap(removedIds);
+    }
+
+    // Posizioni [first, last) degli ID che iniziano con il prefisso (segnaposto compresi)
+    std::pair<std::size_t, std::size_t> range(std::string_view prefix) const {
+        auto first = std::lower_bound(sorted.begin(), sorted.end(), prefix,
+            [this](DeviceHandle entry, std::string_view text) { return idOf(entry) < text; });
+        auto last = std::partition_point(first, sorted.end(),
+            [&](DeviceHandle entry) { return startsWith(entry, prefix); });
+        return {static_cast<std::size_t>(first - sorted.begin()), static_cast<std::size_t>(last - sorted.begin())};
+    }
+
+    // Primo ID dopo from che non inizia con il prefisso (from compreso nel prefisso):
+    // ricerca esponenziale, O(log k) per un intervallo di k ID
+    std::size_t skip(std::string_view prefix, std::size_t from) const {
+        std::size_t step = 1;
+        while (from + step < sorted.size() && startsWith(sorted[from + step], prefix)) {
+            from += step;
+            step *= 2;
+        }
+        std::size_t last = std::min(from + step, sorted.size());
+        return static_cast<std::size_t>(std::partition_point(sorted.begin() + from, sorted.begin() + last,
+            [&](DeviceHandle entry) { return startsWith(entry, prefix); }) - sorted.begin());
+    }
+
+public:
+    explicit NameIndex(const DeviceNames& deviceNames) : names(deviceNames) {}
+
+    std::size_t bytesUsed() const {
+        std::size_t bytes = (sorted.capacity() + pending.capacity()) * sizeof(DeviceHandle)
+                          + removedIds.capacity() * sizeof(std::string);
+        for (const std::string& id : removedIds) {
+            if (id.capacity() > std::string().capacity()) bytes += id.capacity() + 1;
+        }
+        return bytes;
+    }
+
+    // L'ID dell'handle deve essere gia' nella tabella dei nomi
+    void insert(DeviceHandle handle) {
+        if (handle & REMOVED) throw std::length_error("Name index full");
+        if (pending.size() == pending.capacity()) pending.reserve(pending.size() + pending.size() / 8 + 1);   // Come in DeviceNames
+        pending.push_back(handle);
+    }
+
+    // Da chiamare prima di togliere l'ID dalla tabella dei nomi: O(log n)
+    void erase(DeviceHandle handle) {
+        if (pending.size() <= MAX_SCAN) {
+            auto queued = std::find(pending.begin(), pending.end(), handle);
+            if (queued != pending.end()) {
+                pending.erase(queued);
+                return;
+            }
+        }
+        merge();
+        std::string_view id = idOf(handle);
+        auto [first, last] = range(id);
+        // Un segnaposto con lo stesso ID puo' precedere la voce viva
+        for (std::size_t i = first; i < last && idOf(sorted[i]).size() == id.size(); i++) {
+            if (sorted[i] != handle) continue;
+            sorted[i] = REMOVED | static_cast<DeviceHandle>(removedIds.size());
+            removedIds.emplace_back(id);
+            if (removedIds.size() > MAX_SCAN && removedIds.size() * 8 > sorted.size()) purge();
+            return;
+        }
+    }
+
+    // Tutti gli handle in ordine alfabetico di ID
+    const std::vector<DeviceHandle>& ordered() const {
+        merge();
+        purge();
+        return sorted;
+    }
+
+    // Nomi che iniziano con il prefisso, in ordine alfabetico (al massimo limit)
+    std::vector<std::string> withPrefix(std::string_view prefix, std::size_t limit = 50) const {
+        merge();
+        auto [first, last] = range(prefix);
+        std::vector<std::string> out;
+        for (std::size_t i = first; i < last && out.size() < limit; i++) {
+            if (!(sorted[i] & REMOVED)) out.emplace_back(idOf(sorted[i]));
+        }
+        return out;
+    }
+
+    // Estende il prefisso finche' la continuazione e' unica (completamento con TAB):
+    // il prefisso comune al primo e all'ultimo ID dell'intervallo e' comune a tutti
+    std::string complete(std::string_view prefix) const {
+        merge();
+        auto [first, last] = range(prefix);
+        while (first < last && (sorted[first] & REMOVED)) first++;
+        while (last > first && (sorted[last - 1] & REMOVED)) last--;
+        if (first == last) return std::string(prefix);
+        std::string_view lowest = idOf(sorted[first]);
+        return std::string(lowest.substr(0, commonPrefix(lowest, idOf(sorted[last - 1]))));
+    }
+
+    // Nomi entro maxDistance modifiche da name, dal piu' vicino (al massimo limit).
+    // Ricerca approssimata: ogni carattere dell'ID estende di una riga la matrice di
+    // Levenshtein (righe contigue in rows, una per profondita'); gli ID consecutivi
+    // riusano le righe del prefisso comune e, quando il minimo di una riga supera la
+    // distanza massima, si saltano tutti gli ID con quel prefisso
+    std::vector<std::string> suggest(std::string_view name, int maxDistance = 2, std::size_t limit = 5) const {
+        merge();
+        const std::size_t width = name.size() + 1;
+        std::vector<int> rows(width);
+        for (std::size_t j = 0; j <= name.size(); j++) rows[j] = static_cast<int>(j);
+
+        std::vector<std::pair<int, std::string>> found;
+        std::string_view previous;
+        std::size_t depth = 0;                      // Righe valide per previous[0, depth)
+        for (std::size_t i = 0; i < sorted.size();) {
+            if (sorted[i] & REMOVED) {
+                i++;
+                continue;
+            }
+            std::string_view id = idOf(sorted[i]);
+            depth = std::min(depth, commonPrefix(previous, id));
+            bool pruned = false;
+            while (depth < id.size() && !pruned) {
+                const std::size_t row = depth * width, next = row + width;
+                if (rows.size() < next + width) rows.resize(next + width);
+                rows[next] = rows[row] + 1;
+                int best = rows[next];
+                for (std::size_t j = 1; j < width; j++) {
+                    int substitution = rows[row + j - 1] + (name[j - 1] == id[depth] ? 0 : 1);
+                    rows[next + j] = std::min({rows[row + j] + 1, rows[next + j - 1] + 1, substitution});
+                    best = std::min(best, rows[next + j]);
+                }
+                depth++;
+                pruned = best > maxDistance;
+            }
+            previous = id;
+            if (pruned) {
+                i = skip(id.substr(0, depth), i);
+                continue;
+            }
+            if (rows[depth * width + width - 1] <= maxDistance) {
+                found.emplace_back(rows[depth * width + width - 1], std::string(id));
+            }
+            i++;
+        }
+        std::stable_sort(found.begin(), found.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        std::vector<std::string> out;
+        for (std::size_t i = 0; i < found.size() && i < limit; i++) {
+            out.push_back(std::move(found[i].second));
+        }
+        return out;
+    }
+};
+
+#endif // NAME_INDEX_H
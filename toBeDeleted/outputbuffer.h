@@ -0,0 +1,99 @@
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+#include <string>
+#include <charconv>
+#include <iostream>
+#include <string_view>
+#include <unistd.h>
+
+// Buffer di uscita riutilizzabile: i report vengono composti qui con to_chars
+// e scritti con una sola write() per comando. La capacita' resta allocata tra
+// un comando e l'altro, quindi a regime non si alloca piu' nulla.
+class OutputBuffer {
+private:
+    std::string buffer;
+    int fd;
+
+    // Riserva n caratteri in coda e restituisce il puntatore al primo
+    char* grow(std::size_t n) {
+        std::size_t oldSize = buffer.size();
+        buffer.resize(oldSize + n);
+        return &buffer[oldSize];
+    }
+
+    void shrinkTo(const char* end) {
+        buffer.resize(end - buffer.data());
+    }
+
+public:
+    explicit OutputBuffer(int fd = STDOUT_FILENO, std::size_t capacity = 64 * 1024) : fd(fd) {
+        buffer.reserve(capacity);
+    }
+
+    OutputBuffer& operator<<(std::string_view text) {
+        buffer.append(text.data(), text.size());
+        return *this;
+    }
+
+    OutputBuffer& operator<<(char c) {
+        buffer.push_back(c);
+        return *this;
+    }
+
+    OutputBuffer& operator<<(long long value) {
+        char* p = grow(24);
+        shrinkTo(std::to_chars(p, p + 24, value).ptr);
+        return *this;
+    }
+
+    OutputBuffer& operator<<(int value) { return *this << static_cast<long long>(value); }
+
+    // Numero decimale con un numero fisso di cifre dopo la virgola
+    OutputBuffer& fixed(double value, int precision = 3) {
+        char* p = grow(64);
+        shrinkTo(std::to_chars(p, p + 64, value, std::chars_format::fixed, precision).ptr);
+        return *this;
+    }
+
+    // Orario HH:MM a partire dai minuti dalla mezzanotte
+    OutputBuffer& time(int minutes) {
+        char* p = grow(5);
+        int hours = minutes / 60;
+        int mins = minutes % 60;
+        p[0] = static_cast<char>('0' + hours / 10);
+        p[1] = static_cast<char>('0' + hours % 10);
+        p[2] = ':';
+        p[3] = static_cast<char>('0' + mins / 10);
+        p[4] = static_cast<char>('0' + mins % 10);
+        return *this;
+    }
+
+    // Cambia il file descriptor di destinazione (es. /dev/null durante un replay).
+    // Con un fd negativo il contenuto resta nel buffer: lo legge chi chiama view()
+    void redirect(int newFd) {
+        flush();
+        fd = newFd;
+    }
+
+    std::string_view view() const { return buffer; }
+    bool empty() const { return buffer.empty(); }
+    void clear() { buffer.clear(); }
+
+    // Scrive tutto il contenuto con una sola write (piu' eventuali riprese parziali)
+    void flush() {
+        if (buffer.empty() || fd < 0) return;
+        std::cout.flush();  // Non scavalcare l'output gia' accodato su cout
+        const char* p = buffer.data();
+        std::size_t left = buffer.size();
+        while (left > 0) {
+            ssize_t written = ::write(fd, p, left);
+            if (written <= 0) break;
+            p += written;
+            left -= static_cast<std::size_t>(written);
+        }
+        buffer.clear();
+    }
+};
+
+#endif // OUTPUT_BUFFER_H
@@ -0,0 +1,127 @@
+#ifndef PRODUCTION_H
+#define PRODUCTION_H
+
+#include <cmath>
+#include <array>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include "minutes.h"
+
+// Profilo di produzione di un dispositivo produttore (es. fotovoltaico).
+// Tutto il calcolo (interpolazione, trigonometria) avviene al caricamento:
+// durante la simulazione la potenza a un dato minuto e' una sola lettura
+// indicizzata e l'energia prodotta fino a un minuto e' una somma prefissa.
+// Per ogni ora si tengono anche la potenza minima e massima, cosi' chi somma
+// il profilo ad altri carichi sa in quali ore il totale puo' cambiare segno.
+class ProductionProfile {
+public:
+    static constexpr int BLOCK_MINUTES = 60;
+    static constexpr int BLOCKS = MINUTES_PER_DAY / BLOCK_MINUTES;
+
+private:
+    std::array<float, MINUTES_PER_DAY> powerKw{};          // Potenza prodotta in ogni minuto (kW)
+    std::array<double, MINUTES_PER_DAY + 1> energyKwh{};   // energyKwh[m] = energia prodotta in [0, m)
+    std::array<float, BLOCKS> lowestKw{}, highestKw{};     // Potenza minima e massima di ogni ora
+
+    void buildPrefixSums() {
+        energyKwh[0] = 0.0;
+        for (int m = 0; m < MINUTES_PER_DAY; m++) {
+            energyKwh[m + 1] = energyKwh[m] + powerKw[m] / 60.0;
+        }
+        for (int block = 0; block < BLOCKS; block++) {
+            auto first = powerKw.begin() + block * BLOCK_MINUTES;
+            auto [lowest, highest] = std::minmax_element(first, first + BLOCK_MINUTES);
+            lowestKw[block] = *lowest;
+            highestKw[block] = *highest;
+        }
+    }
+
+public:
+    // Curva a mezza sinusoide tra alba e tramonto, con picco a meta' giornata solare
+    static ProductionProfile fromParameters(double peakKw, int sunriseMinute, int sunsetMinute) {
+        if (sunriseMinute < 0 || sunsetMinute > MINUTES_PER_DAY || sunriseMinute >= sunsetMinute) {
+            throw std::invalid_argument("Invalid sunrise/sunset for production profile");
+        }
+        ProductionProfile profile;
+        const double pi = std::acos(-1.0);
+        const double daylight = sunsetMinute - sunriseMinute;
+        for (int m = sunriseMinute; m < sunsetMinute; m++) {
+            profile.powerKw[m] = static_cast<float>(peakKw * std::sin(pi * (m - sunriseMinute) / daylight));
+        }
+        profile.buildPrefixSums();
+        return profile;
+    }
+
+    // File di testo con righe "HH:MM kW" in ordine crescente; '#' introduce un commento.
+    // Tra due punti la potenza e' interpolata linearmente, fuori dall'intervallo resta costante.
+    static ProductionProfile fromFile(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) {
+            throw std::runtime_error("Cannot open production profile: " + path);
+        }
+
+        std::vector<std::pair<int, double>> points;
+        std::string line;
+        while (std::getline(file, line)) {
+            const char* p = line.data();
+            const char* end = p + line.size();
+            while (p < end && (*p == ' ' || *p == '\t')) p++;
+            if (p == end || *p == '#') continue;
+
+            int minute = parseClock(p, end, &p);
+            while (p < end && (*p == ' ' || *p == '\t')) p++;
+            double kw = 0.0;
+            if (minute < 0 || std::from_chars(p, end, kw).ec != std::errc() ||
+                (!points.empty() && minute <= points.back().first)) {
+                throw std::invalid_argument("Invalid production profile line: " + line);
+            }
+            points.emplace_back(minute, kw);
+        }
+        if (points.empty()) {
+            throw std::invalid_argument("Empty production profile: " + path);
+        }
+
+        ProductionProfile profile;
+        std::size_t next = 0;
+        for (int m = 0; m < MINUTES_PER_DAY; m++) {
+            while (next < points.size() && points[next].first <= m) next++;
+            if (next == 0) {
+                profile.powerKw[m] = static_cast<float>(points.front().second);
+            } else if (next == points.size()) {
+                profile.powerKw[m] = static_cast<float>(points.back().second);
+            } else {
+                const auto& [m0, p0] = points[next - 1];
+                const auto& [m1, p1] = points[next];
+                profile.powerKw[m] = static_cast<float>(p0 + (p1 - p0) * (m - m0) / (m1 - m0));
+            }
+        }
+        profile.buildPrefixSums();
+        return profile;
+    }
+
+    // Potenza prodotta al minuto dato (kW, positiva)
+    double powerAt(int minute) const {
+        return powerKw[minute % MINUTES_PER_DAY];
+    }
+
+    // Potenza minima e massima nell'ora block (0..BLOCKS-1) del giorno
+    double lowestInBlock(int block) const { return lowestKw[block]; }
+    double highestInBlock(int block) const { return highestKw[block]; }
+
+    // Energia prodotta da mezzanotte del primo giorno fino al minuto assoluto dato (kWh)
+    double energyUntil(long long minute) const {
+        return (minute / MINUTES_PER_DAY) * energyKwh[MINUTES_PER_DAY] + energyKwh[minute % MINUTES_PER_DAY];
+    }
+
+    // Energia prodotta tra i minuti assoluti from e to (kWh), 0 <= from <= to;
+    // l'intervallo puo' coprire piu' giorni, il profilo si ripete ogni giorno
+    double energyBetween(long long from, long long to) const {
+        return energyUntil(to) - energyUntil(from);
+    }
+};
+
+#endif // PRODUCTION_H
@@ -0,0 +1,91 @@
+#ifndef RESERVATION_TABLE_H
+#define RESERVATION_TABLE_H
+
+#include <array>
+#include <cstdint>
+#include <algorithm>
+#include "minutes.h"
+
+// Potenza impegnata (W) in ogni minuto della giornata, per il controllo di
+// ammissione. Albero di segmenti con aggiunte sugli intervalli: prenotare,
+// liberare, leggere il picco di una finestra e trovare il primo minuto che
+// sfora una soglia costano O(log MINUTES_PER_DAY).
+class ReservationTable {
+private:
+    static constexpr int LEAVES = 2048;             // Potenza di due >= MINUTES_PER_DAY
+    static_assert(LEAVES >= MINUTES_PER_DAY, "LEAVES troppo piccolo");
+
+    // peak[n] = massimo del sottoalbero di n, comprese le aggiunte fatte su n;
+    // added[n] = potenza aggiunta a tutto l'intervallo di n
+    std::array<std::int64_t, 2 * LEAVES> peak{};
+    std::array<std::int64_t, 2 * LEAVES> added{};
+
+    void add(int node, int lo, int hi, int from, int to, std::int64_t watts) {
+        if (to <= lo || hi <= from) return;
+        if (from <= lo && hi <= to) {
+            peak[node] += watts;
+            added[node] += watts;
+            return;
+        }
+        int mid = (lo + hi) / 2;
+        add(2 * node, lo, mid, from, to, watts);
+        add(2 * node + 1, mid, hi, from, to, watts);
+        peak[node] = std::max(peak[2 * node], peak[2 * node + 1]) + added[node];
+    }
+
+    std::int64_t maxOver(int node, int lo, int hi, int from, int to) const {
+        if (from <= lo && hi <= to) return peak[node];
+        int mid = (lo + hi) / 2;
+        std::int64_t best = INT64_MIN;
+        if (from < mid) best = std::max(best, maxOver(2 * node, lo, mid, from, to));
+        if (mid < to) best = std::max(best, maxOver(2 * node + 1, mid, hi, from, to));
+        return best + added[node];
+    }
+
+    // Primo minuto in [from, to) con potenza impegnata > threshold, -1 se nessuno
+    int firstAbove(int node, int lo, int hi, int from, int to, std::int64_t threshold) const {
+        if (to <= lo || hi <= from || peak[node] <= threshold) return -1;
+        if (hi - lo == 1) return lo;
+        threshold -= added[node];
+        int mid = (lo + hi) / 2;
+        int found = firstAbove(2 * node, lo, mid, from, to, threshold);
+        return found >= 0 ? found : firstAbove(2 * node + 1, mid, hi, from, to, threshold);
+    }
+
+public:
+    // Impegna watts (negativo: libera) nei minuti [from, to)
+    void reserve(int from, int to, std::int64_t watts) {
+        from = std::max(from, 0);
+        to = std::min(to, MINUTES_PER_DAY);
+        if (from < to) add(1, 0, LEAVES, from, to, watts);
+    }
+
+    // Picco impegnato nei minuti [from, to) (0 se la finestra e' vuota)
+    std::int64_t peakOver(int from, int to) const {
+        from = std::max(from, 0);
+        to = std::min(to, MINUTES_PER_DAY);
+        return from < to ? maxOver(1, 0, LEAVES, from, to) : 0;
+    }
+
+    // Primo inizio s >= from per cui watts in [s, end(s)) non supera limit;
+    // -1 se non esiste entro la giornata. Ogni tentativo fallito salta oltre il
+    // minuto che sfora, quindi i tentativi sono pochi anche con molti impegni
+    template <typename End>
+    int earliestStart(int from, End&& end, std::int64_t watts, std::int64_t limit) const {
+        for (int start = std::max(from, 0); start < MINUTES_PER_DAY; ) {
+            int stop = std::min(end(start), MINUTES_PER_DAY);
+            if (stop <= start) return start;
+            int blocked = firstAbove(1, 0, LEAVES, start, stop, limit - watts);
+            if (blocked < 0) return start;
+            start = blocked + 1;
+        }
+        return -1;
+    }
+
+    void clear() {
+        peak.fill(0);
+        added.fill(0);
+    }
+};
+
+#endif // RESERVATION_TABLE_H
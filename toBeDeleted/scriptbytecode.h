@@ -0,0 +1,313 @@
+#ifndef SCRIPT_BYTECODE_H
+#define SCRIPT_BYTECODE_H
+
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <charconv>
+#include <stdexcept>
+#include <string_view>
+#include "minutes.h"
+#include "outputbuffer.h"
+#include "time_manager.h"
+
+// Script di scenario compilati in una sequenza compatta di operazioni, per
+// eseguire lo stesso scenario molte volte (studi Monte Carlo) senza rifare
+// tokenizzazione, risoluzione dei nomi e controllo degli argomenti a ogni riga.
+//
+// Il testo usa i comandi dell'interprete, una riga per comando ('#' commenta):
+//     set time HH:MM | set "disp" on|off | set "disp" HH:MM [HH:MM] | rm "disp"
+//     show | show "disp" | show top N | show over kWh | show ["disp"] HH:MM HH:MM
+//     reset time
+// Al posto di un orario o di un numero si puo' scrivere $n: il valore viene
+// preso dal parametro n all'esecuzione (minuti per gli orari, Wh per "over"),
+// che ne controlla l'intervallo come la compilazione fa per i letterali.
+// Gli handle sono risolti alla compilazione: lo script vale per il
+// DeviceManager con cui e' stato compilato, finche' i dispositivi non cambiano.
+
+enum class OpCode : std::uint8_t {
+    SET_TIME,        // operand[0] = minuto
+    TURN_ON,
+    TURN_OFF,
+    SET_TIMER,       // operand[0] = accensione, operand[1] = spegnimento (-1 se assente)
+    REMOVE_TIMER,
+    SHOW,
+    SHOW_DEVICE,
+    SHOW_TOP,        // operand[0] = numero di dispositivi
+    SHOW_OVER,       // operand[0] = soglia in Wh
+    SHOW_WINDOW,     // operand[0..1] = finestra; device INVALID_DEVICE: tutta la casa
+    RESET_TIME
+};
+
+// Operazione a 16 byte
+struct ScriptOp {
+    OpCode code;
+    std::uint8_t fromParameter = 0;            // Bit i: operand[i] e' l'indice di un parametro
+    DeviceHandle device = INVALID_DEVICE;
+    std::int32_t operand[2] = {0, 0};
+};
+
+struct CompiledScript {
+    std::vector<ScriptOp> ops;
+    std::size_t parameterCount = 0;            // Parametri richiesti all'esecuzione
+};
+
+class ScriptCompiler {
+private:
+    struct Word {
+        std::string text;
+        bool quoted;
+    };
+
+    const DeviceManager& deviceManager;
+    CompiledScript script;
+    int line = 0;
+
+    [[noreturn]] void fail(const std::string& message) const {
+        throw std::invalid_argument("Riga " + std::to_string(line) + ": " + message);
+    }
+
+    // Stesse regole dell'interprete: spazi come separatori, nomi tra virgolette
+    std::vector<Word> split(const std::string& text) const {
+        std::vector<Word> words;
+        std::size_t i = 0;
+        while (i < text.size()) {
+            if (text[i] == ' ' || text[i] == '\t' || text[i] == '\r') {
+                i++;
+            } else if (text[i] == '"') {
+                std::size_t close = text.find('"', i + 1);
+                if (close == std::string::npos) fail("virgolette non chiuse");
+                words.push_back({text.substr(i + 1, close - i - 1), true});
+                i = close + 1;
+            } else {
+                std::size_t end = text.find_first_of(" \t\r\"", i);
+                if (end == std::string::npos) end = text.size();
+                words.push_back({text.substr(i, end - i), false});
+                i = end;
+            }
+        }
+        return words;
+    }
+
+    DeviceHandle device(const Word& word) const {
+        if (!word.quoted) fail("atteso un nome di dispositivo tra virgolette");
+        DeviceHandle handle = deviceManager.findHandle(word.text);
+        if (handle == INVALID_DEVICE) fail("dispositivo sconosciuto \"" + word.text + "\"");
+        return handle;
+    }
+
+    bool isParameter(const Word& word) const {
+        return !word.quoted && word.text.size() > 1 && word.text[0] == '$';
+    }
+
+    // $n: segna l'operando come parametro
+    bool parameter(const Word& word, ScriptOp& op, int index) {
+        if (!isParameter(word)) return false;
+        unsigned slot = 0;
+        const char* last = word.text.data() + word.text.size();
+        auto [end, ec] = std::from_chars(word.text.data() + 1, last, slot);
+        if (ec != std::errc() || end != last || slot > 255) fail("parametro non valido " + word.text);
+        op.fromParameter |= static_cast<std::uint8_t>(1u << index);
+        op.operand[index] = static_cast<std::int32_t>(slot);
+        script.parameterCount = std::max<std::size_t>(script.parameterCount, slot + 1);
+        return true;
+    }
+
+    void time(const Word& word, ScriptOp& op, int index, bool allowEndOfDay = false) {
+        if (parameter(word, op, index)) return;
+        const char* last = word.text.data() + word.text.size();
+        const char* next = last;
+        int minutes = parseClock(word.text.data(), last, &next, allowEndOfDay);
+        if (word.quoted || minutes < 0 || next != last) fail("orario non valido " + word.text);
+        op.operand[index] = minutes;
+    }
+
+    void count(const Word& word, ScriptOp& op, int index) {
+        if (parameter(word, op, index)) return;
+        const char* last = word.text.data() + word.text.size();
+        auto [end, ec] = std::from_chars(word.text.data(), last, op.operand[index]);
+        if (word.quoted || ec != std::errc() || end != last || op.operand[index] < 0) fail("numero non valido " + word.text);
+    }
+
+    void wattHours(const Word& word, ScriptOp& op, int index) {
+        if (parameter(word, op, index)) return;
+        double kWh = 0.0;
+        const char* last = word.text.data() + word.text.size();
+        auto [end, ec] = std::from_chars(word.text.data(), last, kWh);
+        // Come per i parametri: da 0 al massimo dell'operando in Wh (anche NaN e' fuori)
+        constexpr double MAX_WH = std::numeric_limits<std::int32_t>::max();
+        if (word.quoted || ec != std::errc() || end != last || !(kWh >= 0.0 && kWh * 1000.0 <= MAX_WH)) {
+            fail("energia non valida " + word.text);
+        }
+        op.operand[index] = static_cast<std::int32_t>(std::lround(kWh * 1000.0));
+    }
+
+    bool isTimeOrParameter(const Word& word) const {
+        if (isParameter(word)) return true;
+        const char* last = word.text.data() + word.text.size();
+        const char* next = last;
+        return !word.quoted && parseClock(word.text.data(), last, &next, true) >= 0 && next == last;
+    }
+
+    void compileLine(const std::vector<Word>& words) {
+        const std::string& command = words[0].text;
+        const std::size_t args = words.size() - 1;
+        ScriptOp op{};
+
+        if (command == "set" && args == 2 && !words[1].quoted && words[1].text == "time") {
+            op.code = OpCode::SET_TIME;
+            time(words[2], op, 0);
+        } else if (command == "set" && (args == 2 || args == 3) && words[1].quoted) {
+            op.device = device(words[1]);
+            if (args == 2 && !words[2].quoted && (words[2].text == "on" || words[2].text == "off")) {
+                op.code = words[2].text == "on" ? OpCode::TURN_ON : OpCode::TURN_OFF;
+            } else {
+                op.code = OpCode::SET_TIMER;
+                time(words[2], op, 0);
+                op.operand[1] = -1;
+                if (args == 3) time(words[3], op, 1);
+            }
+        } else if (command == "rm" && args == 1) {
+            op.code = OpCode::REMOVE_TIMER;
+            op.device = device(words[1]);
+        } else if (command == "show" && args == 0) {
+            op.code = OpCode::SHOW;
+        } else if (command == "show" && args == 1 && words[1].quoted) {
+            op.code = OpCode::SHOW_DEVICE;
+            op.device = device(words[1]);
+        } else if (command == "show" && args == 2 && !words[1].quoted && words[1].text == "top") {
+            op.code = OpCode::SHOW_TOP;
+            count(words[2], op, 0);
+        } else if (command == "show" && args == 2 && !words[1].quoted && words[1].text == "over") {
+            op.code = OpCode::SHOW_OVER;
+            wattHours(words[2], op, 0);
+        } else if (command == "show" && args == 2 && isTimeOrParameter(words[1])) {
+            op.code = OpCode::SHOW_WINDOW;
+            time(words[1], op, 0);
+            time(words[2], op, 1, true);
+        } else if (command == "show" && args == 3 && words[1].quoted) {
+            op.code = OpCode::SHOW_WINDOW;
+            op.device = device(words[1]);
+            time(words[2], op, 0);
+            time(words[3], op, 1, true);
+        } else if (command == "reset" && args == 1 && words[1].text == "time") {
+            op.code = OpCode::RESET_TIME;
+        } else {
+            fail("comando non valido o non supportato negli script: " + command);
+        }
+        script.ops.push_back(op);
+    }
+
+public:
+    explicit ScriptCompiler(const DeviceManager& dm) : deviceManager(dm) {}
+
+    CompiledScript compile(std::istream& in) {
+        script = CompiledScript();
+        line = 0;
+        std::string text;
+        while (std::getline(in, text)) {
+            line++;
+            std::size_t comment = text.find('#');
+            if (comment != std::string::npos) text.erase(comment);
+            std::vector<Word> words = split(text);
+            if (!words.empty()) compileLine(words);
+        }
+        script.ops.shrink_to_fit();
+        return std::move(script);
+    }
+
+    CompiledScript compileFile(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) {
+            throw std::runtime_error("Cannot open script: " + path);
+        }
+        return compile(file);
+    }
+
+    CompiledScript compileText(const std::string& text) {
+        std::istringstream in(text);
+        return compile(in);
+    }
+};
+
+// Operando di un'operazione. I letterali sono stati verificati alla
+// compilazione; i parametri si controllano qui, nell'intervallo [min, max]
+inline int scriptOperand(const ScriptOp& op, int index, const std::vector<int>& parameters, int min, int max) {
+    if (!(op.fromParameter & (1u << index))) return op.operand[index];
+    int value = parameters[op.operand[index]];
+    if (value < min || value > max) {
+        throw std::invalid_argument("Parametro $" + std::to_string(op.operand[index]) + " fuori intervallo: "
+                                    + std::to_string(value) + " (da " + std::to_string(min) + " a " + std::to_string(max) + ")");
+    }
+    return value;
+}
+
+// Esegue lo script direttamente sul modello: un salto per operazione, nessuna
+// stringa. Le eccezioni del DeviceManager/TimeManager arrivano al chiamante
+inline void runScript(const CompiledScript& script, DeviceManager& dm, TimeManager& tm, OutputBuffer& out,
+                      const std::vector<int>& parameters = {}) {
+    if (parameters.size() < script.parameterCount) {
+        throw std::invalid_argument("Lo script richiede " + std::to_string(script.parameterCount) + " parametri");
+    }
+    constexpr int LAST_MINUTE = MINUTES_PER_DAY - 1;
+    constexpr int ANY_COUNT = std::numeric_limits<int>::max();
+    for (const ScriptOp& op : script.ops) {
+        int a, b;
+        switch (op.code) {
+            case OpCode::SET_TIME:
+                tm.setTime(scriptOperand(op, 0, parameters, 0, LAST_MINUTE));
+                break;
+            case OpCode::TURN_ON: {
+                int deferredStart = dm.turnOnDevice(op.device, tm.getCurrentMinutes());
+                if (deferredStart >= 0) {
+                    out << dm.getDeviceId(op.device) << ": accensione rinviata alle ";
+                    out.time(deferredStart) << '\n';
+                } else if (deferredStart == DeviceManager::WAITING_FOR_POWER) {
+                    out << dm.getDeviceId(op.device) << ": accensione in attesa di potenza disponibile\n";
+                }
+                break;
+            }
+            case OpCode::TURN_OFF:
+                dm.turnOffDevice(op.device);
+                break;
+            case OpCode::SET_TIMER:
+                a = scriptOperand(op, 0, parameters, 0, LAST_MINUTE);
+                b = scriptOperand(op, 1, parameters, 0, LAST_MINUTE);     // Il letterale -1 (nessuno spegnimento) non e' un parametro
+                dm.addTimer(op.device, a, b);
+                break;
+            case OpCode::REMOVE_TIMER:
+                dm.removeTimer(op.device);
+                break;
+            case OpCode::SHOW:
+                dm.showConsumption(out, tm.getCurrentMinutes());
+                break;
+            case OpCode::SHOW_DEVICE:
+                out << dm.getDeviceId(op.device) << ": ";
+                out.fixed(dm.getDeviceEnergy(op.device, tm.getCurrentMinutes())) << " kWh\n";
+                break;
+            case OpCode::SHOW_TOP:
+                a = scriptOperand(op, 0, parameters, 0, ANY_COUNT);
+                dm.showTopConsumers(out, static_cast<std::size_t>(a), tm.getCurrentMinutes());
+                break;
+            case OpCode::SHOW_OVER:
+                a = scriptOperand(op, 0, parameters, 0, ANY_COUNT);
+                dm.showConsumersOver(out, a / 1000.0, tm.getCurrentMinutes());
+                break;
+            case OpCode::SHOW_WINDOW:
+                a = scriptOperand(op, 0, parameters, 0, LAST_MINUTE);
+                b = scriptOperand(op, 1, parameters, 0, MINUTES_PER_DAY);
+                dm.showEnergyBetween(out, op.device, a, b);
+                break;
+            case OpCode::RESET_TIME:
+                tm.resetTime();
+                break;
+        }
+    }
+}
+
+#endif // SCRIPT_BYTECODE_H
@@ -0,0 +1,81 @@
+#ifndef SHARD_WORKERS_H
+#define SHARD_WORKERS_H
+
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+
+// Gruppo di thread persistenti per valutare in parallelo i frammenti (shard) di
+// un tick. run(f) chiama f(shard) per ogni shard in [0, size()): lo shard 0 sul
+// thread chiamante, gli altri sui worker, e ritorna quando tutti hanno finito.
+// I thread restano in attesa tra un tick e l'altro, cosi' il costo per tick e'
+// una notifica e non una creazione di thread.
+class ShardWorkers {
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable started;
+    std::condition_variable finished;
+    const std::function<void(unsigned)>* job = nullptr;
+    std::uint64_t generation = 0;   // Incrementato a ogni run()
+    unsigned pending = 0;           // Worker che non hanno ancora finito il run() corrente
+    bool stopping = false;
+
+    void work(unsigned shard) {
+        std::uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            started.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            const std::function<void(unsigned)>* current = job;
+            lock.unlock();
+            (*current)(shard);
+            lock.lock();
+            if (--pending == 0) finished.notify_one();
+        }
+    }
+
+public:
+    // shards: numero totale di shard, compreso quello eseguito dal chiamante
+    explicit ShardWorkers(unsigned shards) {
+        for (unsigned shard = 1; shard < shards; shard++) {
+            threads.emplace_back(&ShardWorkers::work, this, shard);
+        }
+    }
+
+    ShardWorkers(const ShardWorkers&) = delete;
+    ShardWorkers& operator=(const ShardWorkers&) = delete;
+
+    ~ShardWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        started.notify_all();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    unsigned size() const { return static_cast<unsigned>(threads.size()) + 1; }
+
+    // f non deve lanciare eccezioni: gira anche sui worker
+    void run(const std::function<void(unsigned)>& f) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &f;
+            pending = static_cast<unsigned>(threads.size());
+            generation++;
+        }
+        started.notify_all();
+        f(0);
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&] { return pending == 0; });
+    }
+};
+
+#endif // SHARD_WORKERS_H
@@ -0,0 +1,210 @@
+#ifndef SHEDDING_STRATEGY_H
+#define SHEDDING_STRATEGY_H
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+#include "devicearena.h"
+
+// Dispositivo attivo che puo' essere spento per rientrare nel limite di potenza
+struct SheddingCandidate {
+    DeviceHandle device;
+    int priority;        // Higher number = higher priority
+    double load;         // Potenza assorbita in kW (positiva per i consumi)
+};
+
+// Politica di distacco dei carichi. I candidati arrivano in ordine di priorita'
+// crescente; la strategia aggiunge a toShed i dispositivi da spegnere e
+// restituisce false se nemmeno spegnendoli tutti si rientra nel limite.
+class SheddingStrategy {
+public:
+    // Le potenze dei dispositivi sono watt interi: un eccesso residuo sotto il
+    // mezzo watt e' arrotondamento dei double, non potenza da distaccare
+    static constexpr double TOLERANCE_KW = 0.0005;
+
+    virtual ~SheddingStrategy() = default;
+    virtual bool select(const std::vector<SheddingCandidate>& candidates, double excessKw,
+                        std::vector<DeviceHandle>& toShed) = 0;
+};
+
+// Comportamento storico: spegne un dispositivo alla volta partendo dalla
+// priorita' piu' bassa finche' il limite non e' rispettato
+class LowestPriorityFirst : public SheddingStrategy {
+public:
+    bool select(const std::vector<SheddingCandidate>& candidates, double excessKw,
+                std::vector<DeviceHandle>& toShed) override {
+        for (const auto& candidate : candidates) {
+            if (excessKw < TOLERANCE_KW) return true;
+            toShed.push_back(candidate.device);
+            excessKw -= candidate.load;
+        }
+        return excessKw < TOLERANCE_KW;
+    }
+};
+
+// Sceglie l'insieme di dispositivi con la minima perdita pesata per priorita'
+// (priorita' + 1) * kW che copre l'eccesso. E' uno zaino "di copertura" risolto
+// con programmazione dinamica sulla potenza discretizzata: la risoluzione e'
+// di 50 W ma il numero di passi e' limitato, cosi' il costo resta O(n * MAX_STEPS).
+// Le potenze vengono arrotondate per difetto: l'insieme scelto copre sempre
+// l'eccesso reale ed e' ottimo a meno della risoluzione, e non e' mai peggiore
+// di quello di LowestPriorityFirst.
+// Entrano nella programmazione dinamica solo i candidati che possono battere la
+// scelta storica: la loro perdita piu' la copertura frazionaria del resto
+// dell'eccesso (un limite inferiore) deve restare sotto quella della scelta
+// storica. Con molti candidati restano quasi solo le priorita' basse.
+class MinimalLossShedding : public SheddingStrategy {
+private:
+    static constexpr double RESOLUTION_KW = 0.05;
+    static constexpr int MAX_STEPS = 256;
+
+    std::vector<double> best;              // best[w] = perdita minima per coprire almeno w passi
+    std::vector<std::uint64_t> taken;      // Bit w della riga k: l'elemento k ha migliorato best[w]
+    std::vector<int> capFrom;              // capFrom[k] = cella di partenza dell'ultimo miglioramento di best[steps] con k
+    std::vector<std::size_t> items;        // Candidati ammessi alla programmazione dinamica
+    std::vector<double> coveredLoad, coveredLoss;   // Somme prefisse di kW e perdita nell'ordine dei candidati
+    std::vector<std::size_t> chosen, greedy;        // Indici dei candidati scelti dalle due soluzioni
+
+    static int weightOf(double load, double unit, int steps) {
+        return std::min(steps, static_cast<int>(load / unit + 1e-9));
+    }
+
+    static double lossOf(const SheddingCandidate& candidate) {
+        return candidate.load > 0.0 ? (candidate.priority + 1) * candidate.load : 0.0;
+    }
+
+    // Perdita minima per coprire kw spegnendo anche frazioni di dispositivo: i
+    // candidati sono in ordine di perdita per kW, quindi basta prenderli in ordine
+    double fractionalCover(const std::vector<SheddingCandidate>& candidates, double kw) const {
+        if (kw <= 0.0) return 0.0;
+        std::size_t full = static_cast<std::size_t>(
+            std::upper_bound(coveredLoad.begin(), coveredLoad.end(), kw) - coveredLoad.begin()) - 1;
+        if (full + 1 >= coveredLoad.size()) return coveredLoss.back();
+        return coveredLoss[full] + (candidates[full].priority + 1) * (kw - coveredLoad[full]);
+    }
+
+    // Toglie dalla scelta, partendo dalla perdita maggiore, i dispositivi che non
+    // servono a coprire l'eccesso; restituisce la perdita della scelta risultante
+    static double prune(const std::vector<SheddingCandidate>& candidates, double excessKw,
+                        std::vector<std::size_t>& selection) {
+        double slack = TOLERANCE_KW - excessKw;
+        for (std::size_t i : selection) slack += candidates[i].load;
+        std::sort(selection.begin(), selection.end(), [&](std::size_t a, std::size_t b) {
+            return lossOf(candidates[a]) > lossOf(candidates[b]);
+        });
+        double loss = 0.0;
+        std::size_t kept = 0;
+        for (std::size_t i : selection) {
+            if (candidates[i].load <= slack) {
+                slack -= candidates[i].load;
+                continue;
+            }
+            selection[kept++] = i;
+            loss += lossOf(candidates[i]);
+        }
+        selection.resize(kept);
+        return loss;
+    }
+
+public:
+    bool select(const std::vector<SheddingCandidate>& candidates, double excessKw,
+                std::vector<DeviceHandle>& toShed) override {
+        if (excessKw < TOLERANCE_KW) return true;
+
+        double available = 0.0;
+        for (const auto& candidate : candidates) {
+            if (candidate.load > 0.0) available += candidate.load;
+        }
+        if (available <= excessKw - TOLERANCE_KW) {
+            // Impossibile rientrare: spegni comunque tutto cio' che consuma
+            for (const auto& candidate : candidates) {
+                if (candidate.load > 0.0) toShed.push_back(candidate.device);
+            }
+            return false;
+        }
+
+        // Scelta storica, senza i dispositivi superflui: e' il limite da battere
+        greedy.clear();
+        double covered = 0.0;
+        for (std::size_t i = 0; i < candidates.size() && covered <= excessKw - TOLERANCE_KW; i++) {
+            greedy.push_back(i);
+            covered += candidates[i].load;
+        }
+        double lossGreedy = prune(candidates, excessKw, greedy);
+
+        coveredLoad.assign(1, 0.0);
+        coveredLoss.assign(1, 0.0);
+        for (const auto& candidate : candidates) {
+            coveredLoad.push_back(coveredLoad.back() + std::max(candidate.load, 0.0));
+            coveredLoss.push_back(coveredLoss.back() + lossOf(candidate));
+        }
+        items.clear();
+        for (std::size_t i = 0; i < candidates.size(); i++) {
+            if (candidates[i].load <= 0.0) continue;
+            double bound = lossOf(candidates[i]) + fractionalCover(candidates, excessKw - candidates[i].load);
+            if (bound < lossGreedy * (1.0 - 1e-12)) items.push_back(i);
+        }
+
+        const double unit = std::max(RESOLUTION_KW, excessKw / MAX_STEPS);
+        const int steps = static_cast<int>(std::ceil(excessKw / unit - 1e-9));
+        const std::size_t words = static_cast<std::size_t>(steps) / 64 + 1;
+        const double inf = std::numeric_limits<double>::infinity();
+
+        best.assign(static_cast<std::size_t>(steps) + 1, inf);
+        best[0] = 0.0;
+        taken.assign(items.size() * words, 0);
+        capFrom.assign(items.size(), -1);
+
+        int reach = 0;   // Oltre questa cella best[] e' ancora infinito
+        for (std::size_t k = 0; k < items.size(); k++) {
+            const auto& candidate = candidates[items[k]];
+            int weight = weightOf(candidate.load, unit, steps);
+            double loss = lossOf(candidate);
+            std::uint64_t* row = &taken[k * words];
+            for (int w = std::min(steps, reach); w >= 0; w--) {
+                if (best[w] == inf) continue;
+                int reached = std::min(steps, w + weight);
+                if (best[w] + loss < best[reached]) {
+                    best[reached] = best[w] + loss;
+                    row[reached / 64] |= std::uint64_t(1) << (reached % 64);
+                    if (reached == steps) capFrom[k] = w;
+                }
+            }
+            reach += weight;
+        }
+
+        // Ricostruzione all'indietro: se l'elemento k ha migliorato la cella w,
+        // la cella di partenza e' w - peso (o quella salvata per la cella di saturazione)
+        chosen.clear();
+        if (best[steps] != inf) {
+            int w = steps;
+            for (std::size_t k = items.size(); k-- > 0 && w > 0;) {
+                if (!(taken[k * words + static_cast<std::size_t>(w) / 64] >> (w % 64) & 1)) continue;
+                chosen.push_back(items[k]);
+                w = (w == steps) ? capFrom[k] : w - weightOf(candidates[items[k]].load, unit, steps);
+            }
+        }
+
+        // Con molti candidati un passo vale piu' di molti carichi e l'arrotondamento
+        // fa spegnere troppo: si tiene la scelta storica se e' migliore
+        double lossChosen = prune(candidates, excessKw, chosen);
+        const auto& result = (chosen.empty() || lossGreedy < lossChosen) ? greedy : chosen;
+        for (std::size_t i : result) toShed.push_back(candidates[i].device);
+        return true;
+    }
+};
+
+// Strategia per nome, per sceglierla fuori dal codice (opzione --shedding):
+// "lowest" (LowestPriorityFirst) o "minimal" (MinimalLossShedding)
+inline std::unique_ptr<SheddingStrategy> makeSheddingStrategy(std::string_view name) {
+    if (name == "lowest") return std::unique_ptr<SheddingStrategy>(new LowestPriorityFirst());
+    if (name == "minimal") return std::unique_ptr<SheddingStrategy>(new MinimalLossShedding());
+    throw std::invalid_argument("Unknown shedding strategy");
+}
+
+#endif // SHEDDING_STRATEGY_H
@@ -0,0 +1,400 @@
+#ifndef STATIC_HOUSEHOLD_H
+#define STATIC_HOUSEHOLD_H
+
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include "derived_devices.h"
+
+// Casa a configurazione fissa, per i controllori embedded con un elenco di
+// dispositivi noto alla compilazione. Uso:
+//
+//     constexpr DeviceSpec CASA[] = {
+//         manualDevice("frigo", "Frigorifero", -0.4, 5, false),
+//         autoDevice("lavatrice", "Lavatrice", -2.0, 2, 110),
+//     };
+//     StaticHousehold<CASA> casa(3.5);
+//     casa.addTimer(StaticHousehold<CASA>::find("lavatrice"), 8 * 60);
+//
+// Gli stessi ManualDevice/AutoDevice del DeviceManager stanno in un array di
+// dimensione fissa, l'indice di un dispositivo e' la sua posizione nell'elenco
+// e i nomi si risolvono con un hash perfetto calcolato dal compilatore.
+// Nessuna allocazione sull'heap, avvio immediato e tick O(numero di dispositivi).
+struct DeviceSpec {
+    std::string_view id;
+    std::string_view name;
+    double powerKw;          // negative for consumption, positive for production
+    int priority;            // Higher number = higher priority
+    int durationMinutes;     // 0 per i ManualDevice
+    bool canBeForceOff;
+};
+
+constexpr DeviceSpec manualDevice(std::string_view id, std::string_view name, double powerKw,
+                                  int priority, bool canBeForceOff = true) {
+    return {id, name, powerKw, priority, 0, canBeForceOff};
+}
+
+constexpr DeviceSpec autoDevice(std::string_view id, std::string_view name, double powerKw,
+                                int priority, int durationMinutes) {
+    return {id, name, powerKw, priority, durationMinutes, true};
+}
+
+// FNV-1a a 64 bit rimescolato (finalizzatore di SplitMix64, altrimenti ID corti e
+// simili differiscono poco nei bit alti): la parte alta sceglie il gruppo, la
+// bassa la cella (vedi NameTable)
+constexpr std::uint64_t staticNameHash(std::string_view text) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char c : text) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+    return hash ^ (hash >> 31);
+}
+
+// Cella di un ID nel suo gruppo con lo spostamento dato: mescolamento
+// biiettivo (finalizzatore di MurmurHash3), ogni spostamento e' un hash diverso
+constexpr std::uint32_t staticNameSlot(std::uint64_t hash, std::uint32_t displacement) {
+    std::uint32_t x = static_cast<std::uint32_t>(hash) ^ (displacement * 0x9E3779B9u);
+    x ^= x >> 16;
+    x *= 0x85EBCA6Bu;
+    x ^= x >> 13;
+    x *= 0xC2B2AE35u;
+    x ^= x >> 16;
+    return x;
+}
+
+template <const auto& Specs>
+class StaticHousehold {
+public:
+    static constexpr std::size_t SIZE = std::size(Specs);
+    static_assert(SIZE > 0 && SIZE < 0xFFFF, "Numero di dispositivi non supportato");
+
+private:
+    static constexpr std::uint16_t EMPTY = 0xFFFF;       // Cella vuota / timer assente
+
+    static constexpr std::size_t powerOfTwo(std::size_t atLeast) {
+        std::size_t size = 1;
+        while (size < atLeast) size *= 2;
+        return size;
+    }
+
+    // Hash perfetto a due livelli (hash e spostamento, come CHD): gli ID si
+    // dividono in gruppi di circa quattro, e per ogni gruppo, dal piu' numeroso,
+    // si cerca uno spostamento che porti tutti i suoi ID in celle ancora libere.
+    // Con la tabella piena al massimo a meta' bastano pochi tentativi per gruppo:
+    // la costruzione e' O(dispositivi) in media. La ricerca costa un hash, due
+    // letture e un confronto.
+    static constexpr std::size_t TABLE_SIZE = powerOfTwo(2 * SIZE);
+    static constexpr std::size_t BUCKETS = powerOfTwo((SIZE + 3) / 4);
+    static constexpr std::uint32_t MAX_DISPLACEMENT = 0xFFFF;
+
+    struct NameTable {
+        bool unique = true;
+        bool perfect = false;
+        std::array<std::uint16_t, BUCKETS> displacement{};
+        std::array<std::uint16_t, TABLE_SIZE> slot{};
+    };
+
+    static constexpr std::size_t bucketOf(std::uint64_t hash) {
+        return static_cast<std::size_t>(hash >> 32) & (BUCKETS - 1);
+    }
+
+    static constexpr NameTable buildNameTable() {
+        NameTable table;
+        for (auto& slot : table.slot) slot = EMPTY;
+
+        // ID ordinati per gruppo (ordinamento per conteggio), gruppi dal piu' numeroso
+        std::array<std::uint64_t, SIZE> hashes{};
+        std::array<std::uint16_t, BUCKETS + 1> first{};
+        for (std::size_t i = 0; i < SIZE; i++) {
+            hashes[i] = staticNameHash(Specs[i].id);
+            first[bucketOf(hashes[i]) + 1]++;
+        }
+        std::size_t largest = 0;
+        for (std::size_t b = 0; b < BUCKETS; b++) {
+            largest = std::max<std::size_t>(largest, first[b + 1]);
+            first[b + 1] += first[b];
+        }
+        std::array<std::uint16_t, SIZE> members{};
+        std::array<std::uint16_t, BUCKETS> filled{};
+        for (std::size_t i = 0; i < SIZE; i++) {
+            std::size_t b = bucketOf(hashes[i]);
+            members[first[b] + filled[b]++] = static_cast<std::uint16_t>(i);
+        }
+        // ID uguali hanno lo stesso hash: basta confrontare quelli dello stesso gruppo
+        for (std::size_t b = 0; b < BUCKETS; b++) {
+            for (std::size_t i = first[b]; i < first[b + 1]; i++) {
+                for (std::size_t j = i + 1; j < first[b + 1]; j++) {
+                    if (Specs[members[i]].id == Specs[members[j]].id) table.unique = false;
+                }
+            }
+        }
+        if (!table.unique) return table;
+
+        for (std::size_t size = largest; size > 0; size--) {
+            for (std::size_t b = 0; b < BUCKETS; b++) {
+                if (static_cast<std::size_t>(first[b + 1] - first[b]) != size) continue;
+                std::uint32_t d = 0;
+                for (; d <= MAX_DISPLACEMENT; d++) {
+                    std::size_t placed = 0;
+                    for (; placed < size; placed++) {
+                        std::uint16_t device = members[first[b] + placed];
+                        auto& slot = table.slot[staticNameSlot(hashes[device], d) & (TABLE_SIZE - 1)];
+                        if (slot != EMPTY) break;
+                        slot = device;
+                    }
+                    if (placed == size) break;
+                    while (placed > 0) {    // Collisione: libera le celle di questo tentativo
+                        std::uint16_t device = members[first[b] + --placed];
+                        table.slot[staticNameSlot(hashes[device], d) & (TABLE_SIZE - 1)] = EMPTY;
+                    }
+                }
+                if (d > MAX_DISPLACEMENT) return table;
+                table.displacement[b] = static_cast<std::uint16_t>(d);
+            }
+        }
+        table.perfect = true;
+        return table;
+    }
+
+    static constexpr NameTable NAMES = buildNameTable();
+    static_assert(NAMES.unique, "ID dei dispositivi duplicati");
+    static_assert(NAMES.perfect, "Nessun hash perfetto trovato per gli ID dei dispositivi");
+
+    // Ordine degli indici per priorita' (a pari priorita' per posizione): crescente
+    // per il distacco dei carichi, decrescente per le accensioni dei timer
+    static constexpr std::array<std::uint16_t, SIZE> priorityOrder(bool descending) {
+        // Merge sort stabile dal basso: O(n log n) anche per elenchi lunghi
+        std::array<std::uint16_t, SIZE> order{}, merged{};
+        for (std::size_t i = 0; i < SIZE; i++) order[i] = static_cast<std::uint16_t>(i);
+        auto before = [descending](std::uint16_t a, std::uint16_t b) {
+            return descending ? Specs[a].priority > Specs[b].priority : Specs[a].priority < Specs[b].priority;
+        };
+        for (std::size_t width = 1; width < SIZE; width *= 2) {
+            for (std::size_t left = 0; left < SIZE; left += 2 * width) {
+                std::size_t mid = std::min(left + width, SIZE), right = std::min(left + 2 * width, SIZE);
+                std::size_t i = left, j = mid, k = left;
+                while (i < mid && j < right) merged[k++] = before(order[j], order[i]) ? order[j++] : order[i++];
+                while (i < mid) merged[k++] = order[i++];
+                while (j < right) merged[k++] = order[j++];
+            }
+            order = merged;
+        }
+        return order;
+    }
+
+    static constexpr std::array<std::uint16_t, SIZE> SHED_ORDER = priorityOrder(false);
+    static constexpr std::array<std::uint16_t, SIZE> TURN_ON_ORDER = priorityOrder(true);
+
+    static AnyDevice makeDevice(const DeviceSpec& spec) {
+        if (spec.durationMinutes > 0) {
+            return AnyDevice(std::in_place_type<AutoDevice>, spec.powerKw, spec.priority, spec.durationMinutes);
+        }
+        return AnyDevice(std::in_place_type<ManualDevice>, spec.powerKw, spec.priority, spec.canBeForceOff);
+    }
+
+    const std::int64_t maxPowerWatts;
+    std::array<AnyDevice, SIZE> devices;
+    std::array<std::uint16_t, SIZE> timerStart;          // Minuto di accensione (EMPTY se nessun timer)
+    std::array<std::uint16_t, SIZE> timerStop;           // Minuto di spegnimento (EMPTY se assente)
+    std::array<bool, SIZE> turningOn{};                  // Accensioni proposte nel tick corrente
+    std::array<std::uint64_t, SIZE> activation{};        // Numero d'ordine dell'ultima accensione
+    std::array<std::uint16_t, SIZE> sheddable{};         // Candidati di una priorita' durante il distacco
+    std::uint64_t activations = 0;
+    std::int64_t activeLoadWatts = 0;
+    std::int64_t activeProductionWatts = 0;
+    std::uint64_t shedCount = 0;
+    int currentMinute = 0;
+
+    template <std::size_t... I>
+    StaticHousehold(double maxPower, std::index_sequence<I...>)
+        : maxPowerWatts(std::llround(maxPower * 1000.0)), devices{{makeDevice(Specs[I])...}} {
+        timerStart.fill(EMPTY);
+        timerStop.fill(EMPTY);
+    }
+
+    void noteTransition(std::size_t device, bool on) {
+        std::int64_t watts = asDevice(devices[device]).getPowerWatts();
+        std::int64_t delta = on ? std::abs(watts) : -std::abs(watts);
+        if (watts < 0) activeLoadWatts += delta;
+        else activeProductionWatts += delta;
+    }
+
+    void switchOn(std::size_t device) {
+        activation[device] = ++activations;
+        turnOn(devices[device], currentMinute);
+        noteTransition(device, true);
+    }
+
+    void switchOff(std::size_t device) {
+        turnOff(devices[device]);
+        noteTransition(device, false);
+    }
+
+    // Stessa politica del DeviceManager con LowestPriorityFirst: il fotovoltaico
+    // acceso alza il limite, si spegne dalla priorita' piu' bassa e a pari
+    // priorita' dal primo acceso
+    void enforceMaxPowerPolicy() {
+        std::int64_t allowed = maxPowerWatts;
+        if constexpr (PHOTOVOLTAIC >= 0) {
+            const Device& pv = asDevice(devices[PHOTOVOLTAIC]);
+            if (pv.isActive()) allowed += std::abs(pv.getPowerWatts());
+        }
+
+        std::int64_t excess = activeLoadWatts - activeProductionWatts - allowed;
+        for (std::size_t group = 0; group < SIZE && excess > 0;) {
+            int priority = Specs[SHED_ORDER[group]].priority;
+            std::size_t count = 0;
+            for (; group < SIZE && Specs[SHED_ORDER[group]].priority == priority; group++) {
+                std::size_t device = SHED_ORDER[group];
+                if (asDevice(devices[device]).isActive() && canBeTurnedOff(devices[device])) {
+                    sheddable[count++] = static_cast<std::uint16_t>(device);
+                }
+            }
+            std::sort(sheddable.begin(), sheddable.begin() + count, [this](std::uint16_t a, std::uint16_t b) {
+                return activation[a] < activation[b];
+            });
+            for (std::size_t i = 0; i < count && excess > 0; i++) {
+                excess += asDevice(devices[sheddable[i]]).getPowerWatts();
+                switchOff(sheddable[i]);
+                shedCount++;
+            }
+        }
+        if (excess > 0) {
+            throw std::runtime_error("Impossibile rispettare il limite di potenza!");
+        }
+    }
+
+    static std::size_t index(std::string_view id) {
+        int device = find(id);
+        if (device < 0) {
+            throw std::invalid_argument("Device not found");
+        }
+        return static_cast<std::size_t>(device);
+    }
+
+    static void checkIndex(std::size_t device) {
+        if (device >= SIZE) {
+            throw std::invalid_argument("Device not found");
+        }
+    }
+
+public:
+    // Indice del dispositivo con questo ID, -1 se assente (utilizzabile a compile time)
+    static constexpr int find(std::string_view id) {
+        std::uint64_t hash = staticNameHash(id);
+        std::uint16_t device = NAMES.slot[staticNameSlot(hash, NAMES.displacement[bucketOf(hash)]) & (TABLE_SIZE - 1)];
+        return device != EMPTY && Specs[device].id == id ? device : -1;
+    }
+
+    static constexpr int PHOTOVOLTAIC = find("fotovoltaico");
+
+    static constexpr std::string_view getDeviceId(std::size_t device) { return Specs[device].id; }
+    static constexpr std::string_view getDeviceName(std::size_t device) { return Specs[device].name; }
+
+    explicit StaticHousehold(double maxPower = 3.5)
+        : StaticHousehold(maxPower, std::make_index_sequence<SIZE>()) {}
+
+    void turnOnDevice(std::size_t device, int currentTimeMinutes) {
+        checkIndex(device);
+        if (!asDevice(devices[device]).isActive()) {
+            currentMinute = currentTimeMinutes;
+            switchOn(device);
+            enforceMaxPowerPolicy();
+        }
+    }
+
+    void turnOnDevice(std::string_view id, int currentTimeMinutes) {
+        turnOnDevice(index(id), currentTimeMinutes);
+    }
+
+    void turnOffDevice(std::size_t device) {
+        checkIndex(device);
+        if (asDevice(devices[device]).isActive()) switchOff(device);
+    }
+
+    void turnOffDevice(std::string_view id) {
+        turnOffDevice(index(id));
+    }
+
+    // Un timer per dispositivo, come nel DeviceManager: il nuovo sostituisce il vecchio
+    void addTimer(std::size_t device, int startTime, int stopTime = -1) {
+        checkIndex(device);
+        timerStart[device] = static_cast<std::uint16_t>(startTime);
+        timerStop[device] = stopTime < 0 ? EMPTY : static_cast<std::uint16_t>(stopTime);
+    }
+
+    void addTimer(std::string_view id, int startTime, int stopTime = -1) {
+        addTimer(index(id), startTime, stopTime);
+    }
+
+    void removeTimer(std::size_t device) {
+        checkIndex(device);
+        timerStart[device] = EMPTY;
+        timerStop[device] = EMPTY;
+    }
+
+    void removeTimer(std::string_view id) {
+        removeTimer(index(id));
+    }
+
+    // Tick con lo stesso ordine di DeviceManager::checkAndUpdateDevices:
+    // spegnimenti, poi accensioni per priorita' decrescente, un solo controllo finale
+    void checkAndUpdateDevices(int currentTimeMinutes) {
+        currentMinute = currentTimeMinutes;
+
+        bool anyOn = false;
+        for (std::size_t device = 0; device < SIZE; device++) {
+            bool on = asDevice(devices[device]).isActive();
+            bool next = on;
+            if (timerStart[device] != EMPTY) {
+                if (currentTimeMinutes == timerStart[device]) next = true;
+                if (currentTimeMinutes == timerStop[device]) next = false;
+            }
+            if (on) {
+                const auto* autoDevice = std::get_if<AutoDevice>(&devices[device]);
+                if (autoDevice && autoDevice->shouldTurnOff(currentTimeMinutes)) next = false;
+            }
+            turningOn[device] = next && !on;
+            anyOn |= turningOn[device];
+            if (on && !next) switchOff(device);
+        }
+
+        if (anyOn) {
+            for (std::uint16_t device : TURN_ON_ORDER) {
+                if (turningOn[device]) switchOn(device);
+            }
+            enforceMaxPowerPolicy();
+        }
+    }
+
+    // Simula il passaggio del tempo minuto per minuto fino a newTimeMinutes
+    void setTime(int newTimeMinutes) {
+        while (currentMinute < newTimeMinutes) {
+            checkAndUpdateDevices(currentMinute + 1);
+        }
+    }
+
+    int getCurrentMinutes() const { return currentMinute; }
+
+    bool isDeviceActive(std::size_t device) const {
+        return device < SIZE && asDevice(devices[device]).isActive();
+    }
+
+    double getDeviceEnergy(std::size_t device, int totalMinutes) const {
+        return device < SIZE ? asDevice(devices[device]).calculateEnergy(totalMinutes) : 0.0;
+    }
+
+    std::uint64_t getShedCount() const { return shedCount; }
+};
+
+#endif // STATIC_HOUSEHOLD_H
@@ -0,0 +1,209 @@
+#ifndef STATUS_PAGE_H
+#define STATUS_PAGE_H
+
+#include <atomic>
+#include <algorithm>
+#include <string>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Pagina di stato in memoria condivisa POSIX (shm_open), per i monitor esterni.
+//
+// Layout (little endian, campi naturali, nessun padding implicito):
+//
+//   offset  tipo      campo
+//   0       uint32    magic            STATUS_PAGE_MAGIC
+//   4       uint32    version          STATUS_PAGE_VERSION
+//   8       uint64    sequence         seqlock: dispari durante una scrittura
+//   16      int32     currentMinute    minuti dalla mezzanotte dell'ultimo tick
+//   20      uint32    deviceCapacity   bit disponibili in onBits
+//   24      double    gridDrawKw       potenza prelevata dalla rete (batterie comprese)
+//   32      double    photovoltaicKw   potenza prodotta dai produttori attivi, senza batterie
+//   40      double    consumedKwh      energia consumata dall'inizio della simulazione
+//   48      double    producedKwh      energia prodotta dai produttori dall'inizio della simulazione
+//   56      uint64    shedCount        dispositivi spenti dalla politica di potenza
+//   64      uint32    flags            STATUS_OVERFLOW: qualche dispositivo acceso non e' in onBits
+//   68      uint32    reserved
+//   72      double    batteryKw        potenza delle batterie: positiva se cedono alla casa,
+//                                      negativa se si caricano (dalla versione 3)
+//   80      uint64[]  onBits           bit h = dispositivo con handle h acceso
+//
+// Lettura senza syscall: leggere sequence (acquire), scartare se dispari,
+// copiare i campi, rileggere sequence e riprovare se e' cambiata (vedi readStatus).
+// La pagina cresce quando compaiono handle oltre la capacita': chi legge
+// confronta deviceCapacity con la parte che ha mappato e, se e' maggiore, rimappa.
+constexpr std::uint32_t STATUS_PAGE_MAGIC = 0x484D5350;   // "HMSP"
+constexpr std::uint32_t STATUS_PAGE_VERSION = 3;
+constexpr std::uint32_t STATUS_OVERFLOW = 1;
+
+struct StatusHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::atomic<std::uint64_t> sequence;
+    std::int32_t currentMinute;
+    std::uint32_t deviceCapacity;
+    double gridDrawKw;
+    double photovoltaicKw;
+    double consumedKwh;
+    double producedKwh;
+    std::uint64_t shedCount;
+    std::uint32_t flags;
+    std::uint32_t reserved;
+    double batteryKw;
+};
+
+static_assert(sizeof(StatusHeader) == 80, "Il layout della pagina di stato e' fisso");
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Il seqlock richiede atomici senza lock");
+
+inline std::size_t statusPageSize(std::uint32_t deviceCapacity) {
+    return sizeof(StatusHeader) + (deviceCapacity + 63) / 64 * sizeof(std::uint64_t);
+}
+
+inline std::uint64_t* statusBits(StatusHeader* header) {
+    return reinterpret_cast<std::uint64_t*>(header + 1);
+}
+
+inline const std::uint64_t* statusBits(const StatusHeader* header) {
+    return reinterpret_cast<const std::uint64_t*>(header + 1);
+}
+
+// Lato simulatore: crea la pagina e la aggiorna dentro sezioni di scrittura del seqlock
+class StatusPublisher {
+private:
+    std::string name;
+    int fd = -1;                        // Resta aperto per allargare la pagina
+    StatusHeader* header = nullptr;
+    std::size_t size = 0;
+
+    void beginWrite() {
+        header->sequence.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void endWrite() {
+        header->sequence.fetch_add(1, std::memory_order_release);
+    }
+
+    // Raddoppia la capacita' (almeno fino a needed): i byte nuovi del file sono
+    // gia' a zero. Chi legge con la mappatura vecchia continua a leggere i bit
+    // che conosce finche' non rimappa. false se il sistema rifiuta la crescita
+    bool grow(std::uint32_t needed) {
+        std::uint64_t capacity = std::max<std::uint64_t>(needed, std::uint64_t(header->deviceCapacity) * 2);
+        capacity = std::min<std::uint64_t>((capacity + 63) / 64 * 64, 0xFFFFFFC0u);
+        if (capacity < needed) return false;
+        std::size_t newSize = statusPageSize(static_cast<std::uint32_t>(capacity));
+        if (ftruncate(fd, static_cast<off_t>(newSize)) < 0) return false;
+        void* memory = mremap(header, size, newSize, MREMAP_MAYMOVE);
+        if (memory == MAP_FAILED) return false;
+        header = static_cast<StatusHeader*>(memory);
+        size = newSize;
+        beginWrite();
+        header->deviceCapacity = static_cast<std::uint32_t>(capacity);
+        endWrite();
+        return true;
+    }
+
+public:
+    StatusPublisher(const std::string& shmName, std::uint32_t deviceCapacity) : name(shmName) {
+        fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("shm_open " + name + ": " + std::strerror(errno));
+        }
+        size = statusPageSize(deviceCapacity);
+        void* memory = MAP_FAILED;
+        if (ftruncate(fd, static_cast<off_t>(size)) < 0 ||
+            (memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+            std::string error = std::strerror(errno);
+            close(fd);
+            throw std::runtime_error("shm " + name + ": " + error);
+        }
+
+        std::memset(memory, 0, size);
+        header = static_cast<StatusHeader*>(memory);
+        header->magic = STATUS_PAGE_MAGIC;
+        header->version = STATUS_PAGE_VERSION;
+        header->deviceCapacity = deviceCapacity;
+    }
+
+    StatusPublisher(const StatusPublisher&) = delete;
+    StatusPublisher& operator=(const StatusPublisher&) = delete;
+
+    ~StatusPublisher() {
+        munmap(header, size);
+        close(fd);
+        shm_unlink(name.c_str());
+    }
+
+    // Transizione di un singolo dispositivo: aggiorna solo il suo bit. Un handle
+    // oltre la capacita' allarga la pagina; se non si puo', lo segnala in flags
+    void setDeviceOn(std::uint32_t handle, bool on) {
+        if (handle >= header->deviceCapacity && !grow(handle + 1)) {
+            if (on) {
+                beginWrite();
+                header->flags |= STATUS_OVERFLOW;
+                endWrite();
+            }
+            return;
+        }
+        std::uint64_t mask = std::uint64_t(1) << (handle % 64);
+        beginWrite();
+        if (on) statusBits(header)[handle / 64] |= mask;
+        else statusBits(header)[handle / 64] &= ~mask;
+        endWrite();
+    }
+
+    // Valori aggregati, pubblicati una volta per tick: costo O(1)
+    void publish(int currentMinute, double gridDrawKw, double photovoltaicKw, double batteryKw,
+                 double consumedKwh, double producedKwh, std::uint64_t shedCount) {
+        beginWrite();
+        header->currentMinute = currentMinute;
+        header->gridDrawKw = gridDrawKw;
+        header->photovoltaicKw = photovoltaicKw;
+        header->batteryKw = batteryKw;
+        header->consumedKwh = consumedKwh;
+        header->producedKwh = producedKwh;
+        header->shedCount = shedCount;
+        endWrite();
+    }
+};
+
+// Lato monitor: copia coerente dell'intestazione e dei primi mappedCapacity bit
+// (bits deve averne lo spazio; la pagina mappata almeno altrettanti). Se
+// copy.deviceCapacity risulta maggiore, la pagina e' cresciuta: rimappare e rileggere.
+// Nessuna syscall: al piu' qualche tentativo.
+inline void readStatus(const StatusHeader* page, StatusHeader& copy, std::uint64_t* bits = nullptr,
+                       std::uint32_t mappedCapacity = 0) {
+    while (true) {
+        std::uint64_t before = page->sequence.load(std::memory_order_acquire);
+        if (before & 1) continue;
+
+        copy.magic = page->magic;
+        copy.version = page->version;
+        copy.currentMinute = page->currentMinute;
+        copy.deviceCapacity = page->deviceCapacity;
+        copy.gridDrawKw = page->gridDrawKw;
+        copy.photovoltaicKw = page->photovoltaicKw;
+        copy.batteryKw = page->batteryKw;
+        copy.consumedKwh = page->consumedKwh;
+        copy.producedKwh = page->producedKwh;
+        copy.shedCount = page->shedCount;
+        copy.flags = page->flags;
+        if (bits) {
+            std::size_t words = (std::min(copy.deviceCapacity, mappedCapacity) + 63) / 64;
+            std::memcpy(bits, statusBits(page), words * sizeof(std::uint64_t));
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (page->sequence.load(std::memory_order_relaxed) == before) {
+            copy.sequence.store(before, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+#endif // STATUS_PAGE_H
@@ -0,0 +1,130 @@
+#ifndef TARIFF_H
+#define TARIFF_H
+
+#include <array>
+#include <string>
+#include <fstream>
+#include <charconv>
+#include <stdexcept>
+#include "minutes.h"
+#include "production.h"
+
+// Tariffa a fasce orarie con prezzo di immissione per l'energia prodotta.
+// I prezzi vengono espansi al caricamento in una tabella per minuto e poi in
+// somme prefisse: il costo di un intervallo di accensione e' una differenza di
+// due letture, qualunque sia la sua lunghezza (anche su piu' giorni).
+class Tariff {
+private:
+    std::array<double, MINUTES_PER_DAY + 1> priceHours{};   // priceHours[m] = somma di prezzo/60 sui minuti [0, m)
+    double feedInPrice = 0.0;                                // EUR/kWh riconosciuti per l'energia immessa
+
+    void buildPrefixSums(const std::array<double, MINUTES_PER_DAY>& pricePerMinute) {
+        priceHours[0] = 0.0;
+        for (int m = 0; m < MINUTES_PER_DAY; m++) {
+            priceHours[m + 1] = priceHours[m] + pricePerMinute[m] / 60.0;
+        }
+    }
+
+    // Integrale del prezzo da mezzanotte del primo giorno fino al minuto assoluto dato
+    double priceIntegral(long long minute) const {
+        return (minute / MINUTES_PER_DAY) * priceHours[MINUTES_PER_DAY] + priceHours[minute % MINUTES_PER_DAY];
+    }
+
+public:
+    // Tariffa nulla: tutti i costi sono zero
+    Tariff() = default;
+
+    Tariff(const std::array<double, MINUTES_PER_DAY>& pricePerMinute, double feedInPrice)
+        : feedInPrice(feedInPrice) {
+        buildPrefixSums(pricePerMinute);
+    }
+
+    // File di testo con righe "HH:MM HH:MM prezzo" (fasce, fine esclusa, "24:00" ammesso)
+    // e una riga "feedin prezzo"; '#' introduce un commento. Le fasce successive
+    // sovrascrivono le precedenti, i minuti non coperti costano zero.
+    static Tariff fromFile(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) {
+            throw std::runtime_error("Cannot open tariff: " + path);
+        }
+
+        std::array<double, MINUTES_PER_DAY> pricePerMinute{};
+        double feedIn = 0.0;
+        std::string line;
+        while (std::getline(file, line)) {
+            const char* p = line.data();
+            const char* end = p + line.size();
+            auto skipBlanks = [&p, end]() { while (p < end && (*p == ' ' || *p == '\t')) p++; };
+
+            skipBlanks();
+            if (p == end || *p == '#') continue;
+
+            if (line.compare(p - line.data(), 6, "feedin") == 0) {
+                p += 6;
+                skipBlanks();
+                if (std::from_chars(p, end, feedIn).ec != std::errc()) {
+                    throw std::invalid_argument("Invalid tariff line: " + line);
+                }
+                continue;
+            }
+
+            int from = parseClock(p, end, &p);
+            skipBlanks();
+            int to = parseClock(p, end, &p, true);
+            skipBlanks();
+            double price = 0.0;
+            if (from < 0 || to <= from || std::from_chars(p, end, price).ec != std::errc()) {
+                throw std::invalid_argument("Invalid tariff line: " + line);
+            }
+            for (int m = from; m < to; m++) {
+                pricePerMinute[m] = price;
+            }
+        }
+        return Tariff(pricePerMinute, feedIn);
+    }
+
+    // Prezzo (EUR/kWh) nel minuto del giorno indicato
+    double priceAt(int minute) const {
+        int m = minute % MINUTES_PER_DAY;
+        return (priceHours[m + 1] - priceHours[m]) * 60.0;
+    }
+
+    double getFeedInPrice() const { return feedInPrice; }
+
+    // Costo di un intervallo [from, to) a potenza netta costante verso la rete
+    // (kW, negativa se si preleva). Solo l'energia immessa e' valorizzata al
+    // prezzo di immissione (costo negativo).
+    double intervalCost(long long from, long long to, double powerKw) const {
+        if (powerKw > 0.0) {
+            return -feedInPrice * powerKw * (to - from) / 60.0;
+        }
+        return -powerKw * (priceIntegral(to) - priceIntegral(from));
+    }
+
+    // Somme prefisse di prezzo * potenza del profilo (EUR): finche' la casa preleva,
+    // quanto il profilo riduce il costo in [from, to) e' una differenza di due
+    // letture (vedi savedBetween). Vanno ricalcolate se cambia la tariffa
+    std::array<double, MINUTES_PER_DAY + 1> savingSums(const ProductionProfile& profile) const {
+        std::array<double, MINUTES_PER_DAY + 1> sums{};
+        for (int m = 0; m < MINUTES_PER_DAY; m++) {
+            sums[m + 1] = sums[m] + (priceHours[m + 1] - priceHours[m]) * profile.powerAt(m);
+        }
+        return sums;
+    }
+
+    // Risparmio in [from, to) dalle somme di savingSums; minuti assoluti come in intervalCost
+    static double savedBetween(const std::array<double, MINUTES_PER_DAY + 1>& sums, long long from, long long to) {
+        auto until = [&sums](long long minute) {
+            return (minute / MINUTES_PER_DAY) * sums[MINUTES_PER_DAY] + sums[minute % MINUTES_PER_DAY];
+        };
+        return until(to) - until(from);
+    }
+
+    // Ricavo dell'energia prodotta seguendo un profilo in [from, to) se fosse tutta
+    // immessa; i minuti sono assoluti, l'intervallo puo' coprire piu' giorni
+    double intervalCost(long long from, long long to, const ProductionProfile& profile) const {
+        return -feedInPrice * profile.energyBetween(from, to);
+    }
+};
+
+#endif // TARIFF_H
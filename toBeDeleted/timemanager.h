@@ -2,9 +2,9 @@
 #define TIME_MANAGER_H
 
 #include <string>
-#include <sstream>
-#include <iomanip>
 #include <stdexcept>
+#include <string_view>
+#include "minutes.h"
 #include "device_manager.h"
 
 class TimeManager {
@@ -12,31 +12,31 @@ private:
     int currentMinutes;  // Minuti trascorsi dalla mezzanotte
     DeviceManager& deviceManager;
     
-    // Converti una stringa orario (HH:MM) in minuti
-    static int timeStringToMinutes(const std::string& timeStr) {
-        int hours, minutes;
-        char delimiter;
-        std::istringstream ss(timeStr);
-        
-        ss >> hours >> delimiter >> minutes;
-        
-        if (ss.fail() || delimiter != ':' || hours < 0 || hours > 23 || minutes < 0 || minutes > 59) {
+    // Converti una stringa orario (HH:MM) in minuti; -1 se non valida. Nessuna allocazione.
+    static int parseMinutes(std::string_view timeStr) {
+        const char* last = timeStr.data() + timeStr.size();
+        const char* next = last;
+        int minutes = parseClock(timeStr.data(), last, &next);
+        return next == last ? minutes : -1;
+    }
+
+    static int timeStringToMinutes(std::string_view timeStr) {
+        int minutes = parseMinutes(timeStr);
+        if (minutes < 0) {
             throw std::invalid_argument("Invalid time format. Use HH:MM (24h format)");
         }
-        
-        return hours * 60 + minutes;
+        return minutes;
     }
     
     // Converti minuti in stringa orario (HH:MM)
     static std::string minutesToTimeString(int minutes) {
         int hours = minutes / 60;
         int mins = minutes % 60;
-        
-        std::ostringstream ss;
-        ss << std::setfill('0') << std::setw(2) << hours << ":" 
-           << std::setfill('0') << std::setw(2) << mins;
-        
-        return ss.str();
+        char text[5] = {
+            static_cast<char>('0' + hours / 10), static_cast<char>('0' + hours % 10), ':',
+            static_cast<char>('0' + mins / 10), static_cast<char>('0' + mins % 10)
+        };
+        return std::string(text, sizeof(text));
     }
 
     // Verifica se il nuovo orario è valido
@@ -61,8 +61,11 @@ public:
     
     // Imposta un nuovo orario e simula il passaggio del tempo
     void setTime(const std::string& newTime) {
-        int newTimeMinutes = timeStringToMinutes(newTime);
-        
+        setTime(timeStringToMinutes(newTime));
+    }
+
+    // Come sopra, con l'orario gia' convertito in minuti (script compilati)
+    void setTime(int newTimeMinutes) {
         if (!isValidNewTime(newTimeMinutes)) {
             throw std::invalid_argument("New time must be in the future and before 23:59");
         }
@@ -74,24 +77,20 @@ public:
         }
     }
     
-    // Resetta il tempo a 00:00
+    // Resetta il tempo a 00:00 di un nuovo giorno (vedi DeviceManager::resetTime)
     void resetTime() {
         currentMinutes = 0;
+        deviceManager.resetTime();
     }
     
     // Converti una stringa orario in minuti (metodo pubblico per uso esterno)
-    static int convertTimeToMinutes(const std::string& timeStr) {
+    static int convertTimeToMinutes(std::string_view timeStr) {
         return timeStringToMinutes(timeStr);
     }
     
     // Verifica se un orario è nel formato corretto
-    static bool isValidTimeFormat(const std::string& timeStr) {
-        try {
-            timeStringToMinutes(timeStr);
-            return true;
-        } catch (const std::invalid_argument&) {
-            return false;
-        }
+    static bool isValidTimeFormat(std::string_view timeStr) {
+        return parseMinutes(timeStr) >= 0;
     }
 };
 
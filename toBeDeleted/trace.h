@@ -0,0 +1,118 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <sys/resource.h>
+
+// Registrazione delle righe di comando ricevute, per riprodurre offline i
+// problemi di prestazioni. Formato: una riga per comando,
+// "<microsecondi dall'inizio>\t<riga cosi' come ricevuta>".
+class TraceRecorder {
+private:
+    std::ofstream file;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit TraceRecorder(const std::string& path)
+        : file(path, std::ios::out | std::ios::trunc), start(std::chrono::steady_clock::now()) {
+        if (!file) {
+            throw std::runtime_error("Cannot open trace file: " + path);
+        }
+    }
+
+    void record(const std::string& line) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        // Svuotata a ogni riga: la traccia serve proprio quando il processo termina male
+        file << elapsed << '\t' << line << '\n';
+        file.flush();
+    }
+};
+
+// Risultato di una riproduzione
+struct TraceStats {
+    std::size_t commands = 0;
+    long long simulatedMinutes = 0;
+    double seconds = 0.0;
+    double p50Us = 0.0, p90Us = 0.0, p99Us = 0.0, maxUs = 0.0;
+    long peakRssKb = 0;
+
+    double commandsPerSecond() const { return seconds > 0.0 ? commands / seconds : 0.0; }
+    double minutesPerSecond() const { return seconds > 0.0 ? simulatedMinutes / seconds : 0.0; }
+};
+
+// Riproduce una traccia il piu' velocemente possibile: feed(riga) esegue il
+// comando, minutesNow() restituisce l'orario simulato corrente (per contare i
+// minuti simulati; un ritorno all'indietro, es. "reset time", non conta).
+template <typename Feed, typename Clock>
+TraceStats replayTrace(const std::string& path, Feed&& feed, Clock&& minutesNow) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot open trace file: " + path);
+    }
+
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::size_t tab = line.find('\t');
+        lines.push_back(tab == std::string::npos ? line : line.substr(tab + 1));
+    }
+
+    TraceStats stats;
+    std::vector<double> latencies;
+    latencies.reserve(lines.size());
+
+    auto begin = std::chrono::steady_clock::now();
+    for (const auto& command : lines) {
+        int before = minutesNow();
+        auto t0 = std::chrono::steady_clock::now();
+        feed(command);
+        auto t1 = std::chrono::steady_clock::now();
+        latencies.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+        int after = minutesNow();
+        if (after > before) stats.simulatedMinutes += after - before;
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    stats.commands = lines.size();
+
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&latencies](double p) {
+            return latencies[static_cast<std::size_t>(p * (latencies.size() - 1))];
+        };
+        stats.p50Us = percentile(0.50);
+        stats.p90Us = percentile(0.90);
+        stats.p99Us = percentile(0.99);
+        stats.maxUs = latencies.back();
+    }
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        stats.peakRssKb = usage.ru_maxrss;
+    }
+    return stats;
+}
+
+// Baseline di regressione: file con una riga "commands_per_second <valore>".
+// Restituisce 0 se il file non esiste o non contiene il valore.
+inline double readTraceBaseline(const std::string& path) {
+    std::ifstream file(path);
+    std::string key;
+    double value = 0.0;
+    while (file >> key >> value) {
+        if (key == "commands_per_second") return value;
+    }
+    return 0.0;
+}
+
+inline void writeTraceBaseline(const std::string& path, const TraceStats& stats) {
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    file << "commands_per_second " << stats.commandsPerSecond() << '\n';
+}
+
+#endif // TRACE_H